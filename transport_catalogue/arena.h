@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace arena {
+
+    // Непрерывный срез чужого массива без владения: указатель и длина
+    template <typename T>
+    class Span {
+    public:
+        Span() = default;
+
+        Span(const T* data, size_t size)
+            : data_(data)
+            , size_(size) {
+        }
+
+        Span(const std::vector<T>& values)
+            : data_(values.data())
+            , size_(values.size()) {
+        }
+
+        const T* begin() const {
+            return data_;
+        }
+        const T* end() const {
+            return data_ + size_;
+        }
+        std::reverse_iterator<const T*> rbegin() const {
+            return std::reverse_iterator<const T*>(end());
+        }
+        std::reverse_iterator<const T*> rend() const {
+            return std::reverse_iterator<const T*>(begin());
+        }
+
+        const T& operator[](size_t index) const {
+            return data_[index];
+        }
+        const T& front() const {
+            return data_[0];
+        }
+        const T& back() const {
+            return data_[size_ - 1];
+        }
+
+        size_t size() const {
+            return size_;
+        }
+        bool empty() const {
+            return size_ == 0;
+        }
+
+    private:
+        const T* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // Монотонный пул: память берётся крупными блоками и освобождается только вместе с пулом.
+    // Выделенное никогда не перемещается, поэтому указатели и срезы остаются действительными
+    // и при перемещении самого пула. T должен быть тривиальным (char, указатели)
+    template <typename T>
+    class MonotonicPool {
+    public:
+        explicit MonotonicPool(size_t block_size = 4096)
+            : block_size_(block_size) {
+        }
+
+        // копия [first, last) одним непрерывным куском
+        template <typename It>
+        Span<T> Copy(It first, It last) {
+            const size_t count = static_cast<size_t>(std::distance(first, last));
+            T* data = Allocate(count);
+            std::copy(first, last, data);
+            return Span<T>(data, count);
+        }
+
+        // байт занято блоками, включая ещё не использованный хвост последнего
+        size_t GetAllocatedSize() const {
+            return allocated_ * sizeof(T);
+        }
+
+    private:
+        T* Allocate(size_t count) {
+            if (count == 0) {
+                return nullptr;
+            }
+            if (blocks_.empty() || used_ + count > capacity_) {
+                // большой запрос получает отдельный блок, чтобы не терять хвост текущего
+                if (count > block_size_ / 4 && !blocks_.empty()) {
+                    blocks_.insert(std::prev(blocks_.end()), std::make_unique<T[]>(count));
+                    allocated_ += count;
+                    return std::prev(blocks_.end(), 2)->get();
+                }
+                capacity_ = std::max(block_size_, count);
+                blocks_.push_back(std::make_unique<T[]>(capacity_));
+                allocated_ += capacity_;
+                used_ = 0;
+            }
+            T* data = blocks_.back().get() + used_;
+            used_ += count;
+            return data;
+        }
+
+        size_t block_size_;
+        std::vector<std::unique_ptr<T[]>> blocks_;
+        size_t used_ = 0;     // занято в последнем блоке
+        size_t capacity_ = 0; // размер последнего блока
+        size_t allocated_ = 0;
+    };
+
+    // Пул строк: копия хранится до уничтожения пула, string_view на неё не устаревает
+    class StringPool {
+    public:
+        std::string_view Copy(std::string_view value) {
+            const Span<char> copy = chars_.Copy(value.begin(), value.end());
+            return std::string_view(copy.begin(), copy.size());
+        }
+
+        size_t GetAllocatedSize() const {
+            return chars_.GetAllocatedSize();
+        }
+
+    private:
+        MonotonicPool<char> chars_{ 64 * 1024 };
+    };
+
+}
@@ -0,0 +1,107 @@
+#include "catalogue_snapshot.h"
+#include "json_reader.h"
+#include "json_builder.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace catalogue {
+
+	using namespace std::string_literals;
+
+	CatalogueSnapshot::CatalogueSnapshot(Serialization::SerializationOut data, const json::Node* base_requests)
+		: catalogue_(std::move(data.transport_catalogue))
+		, renderer_(std::move(data.map_renderer))
+		, router_(std::move(data.router_settings.graph), std::move(data.router_settings.routes_internal_data), std::move(data.router_settings.contraction_hierarchy),
+			std::move(data.router_settings.stop_vertex_id), std::move(data.router_settings.vertex_id_stop), std::move(data.router_settings.edges_extra_info),
+			data.router_settings.routing_settings) {
+		//индекс строится до обновления: правки (RemoveBus, UpdateBus и т.п.) меняют его строки на месте,
+		//а добавления снимают заморозку, и тогда индекс строится заново
+		catalogue_.Freeze();
+		if (base_requests != nullptr) {
+			reader::ApplyBaseRequests(catalogue_, router_, *base_requests);
+		}
+		if (!catalogue_.IsFrozen()) {
+			catalogue_.Freeze();
+		}
+		timetable_router_.emplace(catalogue_, data.router_settings.routing_settings.bus_velocity);
+		stops_index_.emplace(catalogue_);
+		request_handler_.emplace(catalogue_, renderer_, router_, *timetable_router_, *stops_index_);
+	}
+
+	const TransportCatalogue& CatalogueSnapshot::GetCatalogue() const
+	{
+		return catalogue_;
+	}
+
+	const transport_router::TransportRouter& CatalogueSnapshot::GetRouter() const
+	{
+		return router_;
+	}
+
+	const RequestHandler& CatalogueSnapshot::GetRequestHandler() const
+	{
+		return *request_handler_;
+	}
+
+	Serialization::SerializationOut CatalogueSnapshot::Copy() const
+	{
+		return Serialization::Copy(catalogue_, renderer_, router_);
+	}
+
+	LiveCatalogue::LiveCatalogue(Serialization::SerializationOut data)
+		: publisher_(std::make_unique<const CatalogueSnapshot>(std::move(data))) {
+	}
+
+	LiveCatalogue::Reader LiveCatalogue::Read() const
+	{
+		return publisher_.Read();
+	}
+
+	std::uint64_t LiveCatalogue::Update(const json::Node& base_requests)
+	{
+		std::lock_guard lock(update_mutex_);
+		//прежние обновления в текущей версии уже есть: применяем только новое
+		auto next = std::make_unique<const CatalogueSnapshot>(Read()->Copy(), &base_requests);
+		return publisher_.Publish(std::move(next));
+	}
+
+	json::Document LiveCatalogue::ProcessStatRequests(const json::Node& stat_requests)
+	{
+		json::Array out;
+		for (const json::Node& request : stat_requests.AsArray()) {
+			const json::Dict& request_dict = request.AsDict();
+			if (request_dict.at("type"s) == "Update"s) {
+				const int id = request_dict.at("id"s).AsInt();
+				const auto error = [id](const std::string& error_message) {
+					return json::Builder{}.StartDict()
+						.Key("request_id"s).Value(id)
+						.Key("error_message"s).Value(error_message)
+						.EndDict().Build();
+				};
+				//неудачное обновление не публикуется: следующие запросы видят прежнюю версию
+				try {
+					const std::uint64_t version = Update(request_dict.at("base_requests"s));
+					out.push_back(json::Builder{}.StartDict()
+						.Key("request_id"s).Value(id)
+						.Key("version"s).Value(RequestHandler::SizeToJson(version).GetValue())
+						.EndDict().Build());
+				}
+				catch (const std::out_of_range&) { //неизвестное название
+					out.push_back(error("not found"s));
+				}
+				catch (const std::logic_error& e) {
+					out.push_back(error(e.what()));
+				}
+				continue;
+			}
+			//версия удерживается до конца ответа, даже если тем временем опубликуют новую
+			const Reader snapshot = Read();
+			out.push_back(reader::ParseStatRequest(snapshot->GetRequestHandler(), request));
+		}
+		return json::Document{ out };
+	}
+
+}
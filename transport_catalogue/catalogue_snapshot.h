@@ -0,0 +1,66 @@
+#pragma once
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+#include "timetable_router.h"
+#include "stops_index.h"
+#include "request_handler.h"
+#include "serialization.h"
+#include "snapshot.h"
+#include "json.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+namespace catalogue {
+
+	//Неизменяемая версия базы со всем, что нужно для ответа на stat_requests.
+	//Части ссылаются друг на друга, поэтому версия не копируется и не перемещается
+	class CatalogueSnapshot {
+	public:
+		//база data и, если задан, поверх неё base_requests
+		explicit CatalogueSnapshot(Serialization::SerializationOut data, const json::Node* base_requests = nullptr);
+		CatalogueSnapshot(const CatalogueSnapshot&) = delete;
+		CatalogueSnapshot& operator=(const CatalogueSnapshot&) = delete;
+
+		const TransportCatalogue& GetCatalogue() const;
+		const transport_router::TransportRouter& GetRouter() const;
+		const RequestHandler& GetRequestHandler() const;
+
+		//независимая от этой версии копия базы: из неё строится следующая
+		Serialization::SerializationOut Copy() const;
+
+	private:
+		TransportCatalogue catalogue_;
+		renderer::MapRenderer renderer_;
+		transport_router::TransportRouter router_;
+		std::optional<timetable_router::TimetableRouter> timetable_router_;
+		std::optional<StopsIndex> stops_index_;
+		std::optional<RequestHandler> request_handler_;
+	};
+
+	//База, которую можно обновлять, не прерывая обработку запросов. Запросы читают текущую версию
+	//без блокировок; Update строит следующую версию из копии текущей и одного нового обновления
+	//и публикует её атомарно. Обновления живут только в памяти: файл базы пишет update_base
+	class LiveCatalogue {
+	public:
+		using Reader = rcu::SnapshotPublisher<CatalogueSnapshot>::Reader;
+
+		explicit LiveCatalogue(Serialization::SerializationOut data);
+
+		Reader Read() const;
+
+		//номер опубликованной версии; исходная база — версия 1. Если обновление выполнить нельзя
+		//(неизвестное название, удаление остановки, через которую идёт маршрут), исключение, и ничего не публикуется
+		std::uint64_t Update(const json::Node& base_requests);
+
+		//запросы по порядку; запрос Update публикует новую версию для всех следующих,
+		//а неудачный отвечает error_message
+		json::Document ProcessStatRequests(const json::Node& stat_requests);
+
+	private:
+		std::mutex update_mutex_; //писатели по очереди, читатели их не ждут
+		rcu::SnapshotPublisher<CatalogueSnapshot> publisher_;
+	};
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+#include "graph.h"
+#include "memory_stats.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Маршрутизатор на иерархиях сжатия (Contraction Hierarchies).
+    // Предподсчёт по очереди "сжимает" вершины, добавляя рёбра-сокращения (shortcuts) там,
+    // где через сжатую вершину проходил единственный кратчайший путь. Запрос — двунаправленный
+    // Дейкстра только по рёбрам, ведущим к вершинам с большим рангом; найденные сокращения
+    // раскрываются обратно в исходные рёбра графа.
+    template <typename Weight>
+    class ContractionHierarchy {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+        using ArcId = size_t;
+
+        // Ребро иерархии: либо исходное ребро edge_id графа, либо сокращение из двух
+        // последовательных рёбер иерархии first и second
+        struct Arc {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            std::optional<EdgeId> edge_id;
+            ArcId first = 0;
+            ArcId second = 0;
+        };
+
+        // То, что сохраняется при сериализации; списки для поиска восстанавливаются по нему
+        struct Data {
+            std::vector<size_t> ranks;
+            std::vector<Arc> arcs;
+        };
+
+        explicit ContractionHierarchy(const Graph& graph);
+        explicit ContractionHierarchy(const Graph& graph, Data data);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        const Data& GetData() const;
+
+        memory::MemoryStats GetMemoryStats() const;
+
+    private:
+        class Contractor;
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+        void BuildSearchLists();
+        void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+        const Graph& graph_;
+        Data data_;
+        std::vector<std::vector<ArcId>> upward_arcs_;   //рёбра из вершины в вершины большего ранга
+        std::vector<std::vector<ArcId>> downward_arcs_; //рёбра в вершину из вершин большего ранга
+    };
+
+    // Предподсчёт: оверлейный граф из ещё не сжатых вершин и порядок сжатия
+    // по ленивой очереди с приоритетом "разность рёбер + число сжатых соседей"
+    template <typename Weight>
+    class ContractionHierarchy<Weight>::Contractor {
+    public:
+        explicit Contractor(const Graph& graph, Data& data)
+            : data_(data)
+            , out_(graph.GetVertexCount())
+            , in_(graph.GetVertexCount())
+            , contracted_neighbors_(graph.GetVertexCount())
+            , witness_weights_(graph.GetVertexCount())
+        {
+            for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+                const auto& edge = graph.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                if (edge.from == edge.to) {
+                    continue;
+                }
+                //из параллельных рёбер оставляем самое лёгкое
+                const auto it = out_[edge.from].find(edge.to);
+                if (it == out_[edge.from].end() || edge.weight < data_.arcs[it->second].weight) {
+                    AddArc({ edge.from, edge.to, edge.weight, edge_id });
+                }
+            }
+        }
+
+        void Run() {
+            const size_t vertex_count = out_.size();
+            data_.ranks.assign(vertex_count, 0);
+            std::priority_queue<std::pair<int, VertexId>, std::vector<std::pair<int, VertexId>>, std::greater<>> queue;
+            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                queue.push({ GetPriority(vertex), vertex });
+            }
+            size_t rank = 0;
+            while (!queue.empty()) {
+                const VertexId vertex = queue.top().second;
+                queue.pop();
+                //приоритет мог устареть после сжатия соседей: пересчитываем и, если вершина
+                //перестала быть лучшей, откладываем её
+                const int priority = GetPriority(vertex);
+                if (!queue.empty() && priority > queue.top().first) {
+                    queue.push({ priority, vertex });
+                    continue;
+                }
+                Contract(vertex);
+                data_.ranks[vertex] = rank++;
+            }
+        }
+
+    private:
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            ArcId first;
+            ArcId second;
+        };
+
+        //ограничения поиска свидетелей: для оценки приоритета и для настоящего сжатия
+        static constexpr size_t PRIORITY_WITNESS_SETTLED_LIMIT = 20;
+        static constexpr size_t CONTRACT_WITNESS_SETTLED_LIMIT = 100;
+
+        void AddArc(Arc arc) {
+            data_.arcs.push_back(arc);
+            const ArcId arc_id = data_.arcs.size() - 1;
+            out_[arc.from][arc.to] = arc_id;
+            in_[arc.to][arc.from] = arc_id;
+        }
+
+        int GetPriority(VertexId vertex) {
+            const int removed = static_cast<int>(in_[vertex].size() + out_[vertex].size());
+            const int added = static_cast<int>(FindShortcuts(vertex, PRIORITY_WITNESS_SETTLED_LIMIT).size());
+            return added - removed + contracted_neighbors_[vertex];
+        }
+
+        // Сокращение u -> x нужно, если без vertex нет пути из u в x не длиннее u -> vertex -> x.
+        // Сначала проверяется прямое ребро u -> x (в транспортном графе оно почти всегда есть),
+        // и только для непокрытых им x запускается ограниченный поиск свидетелей. Из-за
+        // ограничения иногда добавляются лишние сокращения — на корректность это не влияет
+        std::vector<Shortcut> FindShortcuts(VertexId vertex, size_t settled_limit) {
+            std::vector<Shortcut> shortcuts;
+            std::vector<Shortcut> candidates;
+            for (const auto& [from, in_arc] : in_[vertex]) {
+                const auto& out_from = out_[from];
+                Weight max_weight = ZERO_WEIGHT;
+                candidates.clear();
+                for (const auto& [to, out_arc] : out_[vertex]) {
+                    if (to == from) {
+                        continue;
+                    }
+                    const Weight weight = data_.arcs[in_arc].weight + data_.arcs[out_arc].weight;
+                    if (const auto it = out_from.find(to); it != out_from.end() && !(weight < data_.arcs[it->second].weight)) {
+                        continue;
+                    }
+                    candidates.push_back({ from, to, weight, in_arc, out_arc });
+                    max_weight = std::max(max_weight, weight);
+                }
+                if (candidates.empty()) {
+                    continue;
+                }
+                FindWitnesses(from, vertex, max_weight, settled_limit);
+                for (const Shortcut& candidate : candidates) {
+                    const auto& witness_weight = witness_weights_[candidate.to];
+                    if (!witness_weight || candidate.weight < *witness_weight) {
+                        shortcuts.push_back(candidate);
+                    }
+                }
+                for (const VertexId touched : witness_touched_) {
+                    witness_weights_[touched].reset();
+                }
+                witness_touched_.clear();
+            }
+            return shortcuts;
+        }
+
+        void FindWitnesses(VertexId from, VertexId excluded, Weight max_weight, size_t settled_limit) {
+            Queue queue;
+            witness_weights_[from] = ZERO_WEIGHT;
+            witness_touched_.push_back(from);
+            queue.push({ ZERO_WEIGHT, from });
+            size_t settled = 0;
+            while (!queue.empty() && settled < settled_limit) {
+                const auto [weight, vertex] = queue.top();
+                queue.pop();
+                if (*witness_weights_[vertex] < weight) {
+                    continue;
+                }
+                if (max_weight < weight) {
+                    break;
+                }
+                ++settled;
+                for (const auto& [to, arc_id] : out_[vertex]) {
+                    if (to == excluded) {
+                        continue;
+                    }
+                    const Weight candidate_weight = weight + data_.arcs[arc_id].weight;
+                    auto& weight_to = witness_weights_[to];
+                    if (!weight_to || candidate_weight < *weight_to) {
+                        if (!weight_to) {
+                            witness_touched_.push_back(to);
+                        }
+                        weight_to = candidate_weight;
+                        queue.push({ candidate_weight, to });
+                    }
+                }
+            }
+        }
+
+        void Contract(VertexId vertex) {
+            for (const Shortcut& shortcut : FindShortcuts(vertex, CONTRACT_WITNESS_SETTLED_LIMIT)) {
+                const auto it = out_[shortcut.from].find(shortcut.to);
+                if (it == out_[shortcut.from].end() || shortcut.weight < data_.arcs[it->second].weight) {
+                    AddArc({ shortcut.from, shortcut.to, shortcut.weight, std::nullopt, shortcut.first, shortcut.second });
+                }
+            }
+            for (const auto& [from, arc_id] : in_[vertex]) {
+                out_[from].erase(vertex);
+                ++contracted_neighbors_[from];
+            }
+            for (const auto& [to, arc_id] : out_[vertex]) {
+                in_[to].erase(vertex);
+                ++contracted_neighbors_[to];
+            }
+            in_[vertex].clear();
+            out_[vertex].clear();
+        }
+
+        Data& data_;
+        std::vector<std::unordered_map<VertexId, ArcId>> out_;
+        std::vector<std::unordered_map<VertexId, ArcId>> in_;
+        std::vector<int> contracted_neighbors_;
+        std::vector<std::optional<Weight>> witness_weights_;
+        std::vector<VertexId> witness_touched_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+        : graph_(graph)
+    {
+        Contractor contractor(graph, data_);
+        contractor.Run();
+        BuildSearchLists();
+    }
+
+    template <typename Weight>
+    ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, Data data)
+        : graph_(graph)
+        , data_(std::move(data))
+    {
+        if (data_.ranks.size() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+        BuildSearchLists();
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::BuildSearchLists() {
+        upward_arcs_.assign(data_.ranks.size(), {});
+        downward_arcs_.assign(data_.ranks.size(), {});
+        for (ArcId arc_id = 0; arc_id < data_.arcs.size(); ++arc_id) {
+            const Arc& arc = data_.arcs[arc_id];
+            if (data_.ranks.at(arc.from) < data_.ranks.at(arc.to)) {
+                upward_arcs_[arc.from].push_back(arc_id);
+            }
+            else {
+                downward_arcs_[arc.to].push_back(arc_id);
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        const size_t vertex_count = data_.ranks.size();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        //индекс 0 — прямой поиск от from, индекс 1 — обратный от to
+        std::vector<std::optional<Weight>> weights[2] = { std::vector<std::optional<Weight>>(vertex_count),
+            std::vector<std::optional<Weight>>(vertex_count) };
+        std::vector<ArcId> prev_arcs[2] = { std::vector<ArcId>(vertex_count, NO_ARC), std::vector<ArcId>(vertex_count, NO_ARC) };
+        Queue queues[2];
+        const std::vector<std::vector<ArcId>>* arcs[2] = { &upward_arcs_, &downward_arcs_ };
+
+        weights[0][from] = ZERO_WEIGHT;
+        weights[1][to] = ZERO_WEIGHT;
+        queues[0].push({ ZERO_WEIGHT, from });
+        queues[1].push({ ZERO_WEIGHT, to });
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+
+        while (!queues[0].empty() || !queues[1].empty()) {
+            const int side = queues[1].empty() || (!queues[0].empty() && queues[0].top() <= queues[1].top()) ? 0 : 1;
+            const auto [weight, vertex] = queues[side].top();
+            if (best_weight && !(weight < *best_weight)) { //обе очереди уже не могут улучшить ответ
+                break;
+            }
+            queues[side].pop();
+            if (*weights[side][vertex] < weight) {
+                continue;
+            }
+            if (const auto& other_weight = weights[1 - side][vertex]) {
+                if (!best_weight || weight + *other_weight < *best_weight) {
+                    best_weight = weight + *other_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+            for (const ArcId arc_id : (*arcs[side])[vertex]) {
+                const Arc& arc = data_.arcs[arc_id];
+                const VertexId next = side == 0 ? arc.to : arc.from;
+                const Weight candidate_weight = weight + arc.weight;
+                auto& weight_next = weights[side][next];
+                if (!weight_next || candidate_weight < *weight_next) {
+                    weight_next = candidate_weight;
+                    prev_arcs[side][next] = arc_id;
+                    queues[side].push({ candidate_weight, next });
+                }
+            }
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        std::vector<ArcId> forward_arcs;
+        for (VertexId vertex = meeting_vertex; prev_arcs[0][vertex] != NO_ARC; vertex = data_.arcs[prev_arcs[0][vertex]].from) {
+            forward_arcs.push_back(prev_arcs[0][vertex]);
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); ++it) {
+            UnpackArc(*it, edges);
+        }
+        for (VertexId vertex = meeting_vertex; prev_arcs[1][vertex] != NO_ARC; vertex = data_.arcs[prev_arcs[1][vertex]].to) {
+            UnpackArc(prev_arcs[1][vertex], edges);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+        std::vector<ArcId> stack{ arc_id };
+        while (!stack.empty()) {
+            const Arc& arc = data_.arcs[stack.back()];
+            stack.pop_back();
+            if (arc.edge_id) {
+                edges.push_back(*arc.edge_id);
+            }
+            else {
+                stack.push_back(arc.second);
+                stack.push_back(arc.first);
+            }
+        }
+    }
+
+    template <typename Weight>
+    const typename ContractionHierarchy<Weight>::Data& ContractionHierarchy<Weight>::GetData() const {
+        return data_;
+    }
+
+    template <typename Weight>
+    memory::MemoryStats ContractionHierarchy<Weight>::GetMemoryStats() const {
+        return {
+            memory::Describe("data_.ranks", data_.ranks),
+            memory::Describe("data_.arcs", data_.arcs),
+            memory::Describe("upward_arcs_", upward_arcs_),
+            memory::Describe("downward_arcs_", downward_arcs_),
+        };
+    }
+
+}  // namespace graph
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Маршрутизатор без предподсчёта: каждый BuildRoute запускает алгоритм Дейкстры
+    // от вершины from и останавливается, как только достигнута вершина to.
+    // Память O(V + E), построение O(E), запрос O(E log V).
+    // Перегрузка BuildRoute с эвристикой — A*: вершины извлекаются в порядке
+    // "вес пути + heuristic(vertex)". Эвристика должна быть согласованной
+    // (heuristic(u) <= weight(u -> v) + heuristic(v), heuristic(to) == 0),
+    // тогда найденный путь по-прежнему оптимален.
+    template <typename Weight>
+    class DijkstraRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        explicit DijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        template <typename Heuristic>
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, Heuristic heuristic) const;
+
+        // Веса кратчайших путей из from во все вершины targets (nullopt — недостижима).
+        // Один поиск на все цели; он останавливается, как только все цели извлечены из очереди
+        std::vector<std::optional<Weight>> BuildWeights(VertexId from, const std::vector<VertexId>& targets) const;
+
+        // Все вершины, достижимые из from путём веса не больше max_weight, вместе с весами
+        // кратчайших путей, в порядке неубывания веса. Поиск не выходит за max_weight
+        std::vector<std::pair<VertexId, Weight>> BuildWeightsWithin(VertexId from, Weight max_weight) const;
+
+    private:
+        using QueueItem = std::tuple<Weight, Weight, VertexId>; //оценка "вес + эвристика", вес, вершина
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+        : graph_(graph)
+    {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        return BuildRoute(from, to, [](VertexId) { return ZERO_WEIGHT; });
+    }
+
+    template <typename Weight>
+    template <typename Heuristic>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to, Heuristic heuristic) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::vector<std::optional<EdgeId>> prev_edges(vertex_count);
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        weights[from] = ZERO_WEIGHT;
+        queue.push({ heuristic(from), ZERO_WEIGHT, from });
+        while (!queue.empty()) {
+            const auto [estimate, weight, vertex] = queue.top();
+            queue.pop();
+            if (*weights[vertex] < weight) { //устаревшая запись в очереди
+                continue;
+            }
+            if (vertex == to) {
+                break;
+            }
+            const Weight weight_from = weight;
+            graph_.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, const Weight& edge_weight) {
+                const Weight candidate_weight = weight_from + edge_weight;
+                auto& weight_to = weights[edge_to];
+                if (!weight_to || candidate_weight < *weight_to) {
+                    weight_to = candidate_weight;
+                    prev_edges[edge_to] = edge_id;
+                    queue.push({ candidate_weight + heuristic(edge_to), candidate_weight, edge_to });
+                }
+            });
+        }
+
+        if (!weights[to]) { //вершина to недостижима
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[to];
+            edge_id;
+            edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ *weights[to], std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildWeights(VertexId from,
+        const std::vector<VertexId>& targets) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        std::vector<bool> is_target(vertex_count, false);
+        size_t targets_left = 0;
+        for (const VertexId target : targets) {
+            if (target >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+            if (!is_target[target]) {
+                is_target[target] = true;
+                ++targets_left;
+            }
+        }
+
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        weights[from] = ZERO_WEIGHT;
+        queue.push({ ZERO_WEIGHT, ZERO_WEIGHT, from });
+        while (!queue.empty() && targets_left != 0) {
+            const auto [estimate, weight, vertex] = queue.top();
+            queue.pop();
+            if (*weights[vertex] < weight) {
+                continue;
+            }
+            if (is_target[vertex]) {
+                is_target[vertex] = false;
+                --targets_left;
+            }
+            const Weight weight_from = weight;
+            graph_.ForEachIncidentEdge(vertex, [&](EdgeId, VertexId edge_to, const Weight& edge_weight) {
+                const Weight candidate_weight = weight_from + edge_weight;
+                auto& weight_to = weights[edge_to];
+                if (!weight_to || candidate_weight < *weight_to) {
+                    weight_to = candidate_weight;
+                    queue.push({ candidate_weight, candidate_weight, edge_to });
+                }
+            });
+        }
+
+        std::vector<std::optional<Weight>> result;
+        result.reserve(targets.size());
+        for (const VertexId target : targets) {
+            result.push_back(weights[target]);
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildWeightsWithin(VertexId from,
+        Weight max_weight) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+
+        std::vector<std::optional<Weight>> weights(vertex_count);
+        std::vector<std::pair<VertexId, Weight>> result;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        weights[from] = ZERO_WEIGHT;
+        queue.push({ ZERO_WEIGHT, ZERO_WEIGHT, from });
+        while (!queue.empty()) {
+            const auto [estimate, weight, vertex] = queue.top();
+            queue.pop();
+            if (*weights[vertex] < weight) {
+                continue;
+            }
+            result.emplace_back(vertex, weight);
+            const Weight weight_from = weight;
+            graph_.ForEachIncidentEdge(vertex, [&](EdgeId, VertexId edge_to, const Weight& edge_weight) {
+                const Weight candidate_weight = weight_from + edge_weight;
+                if (max_weight < candidate_weight) { //за пределы бюджета не выходим
+                    return;
+                }
+                auto& weight_to = weights[edge_to];
+                if (!weight_to || candidate_weight < *weight_to) {
+                    weight_to = candidate_weight;
+                    queue.push({ candidate_weight, candidate_weight, edge_to });
+                }
+            });
+        }
+        return result;
+    }
+
+}  // namespace graph
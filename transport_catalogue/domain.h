@@ -1,22 +1,32 @@
 #pragma once
 #include "geo.h"
+#include "arena.h"
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <set>
 
 namespace catalogue {
 
+	//плотные номера в порядке добавления в справочник: 0, 1, 2, ...
+	using StopId = std::uint32_t;
+	using BusId = std::uint32_t;
+
+	//Названия и списки остановок маршрутов принадлежат пулам справочника: AddStop/AddBus копируют их туда,
+	//так что при добавлении name и stops могут ссылаться на временные данные вызывающего
 	struct Stop {
-		std::string name;
+		std::string_view name;
 		geo::Coordinates coordinates;
+		StopId id = 0; //назначается в TransportCatalogue::AddStop
 	};
 
 	struct Bus {
-		std::string name;
-		std::vector<const Stop*> stops;
+		std::string_view name;
+		arena::Span<const Stop*> stops;
 		bool is_roundtrip = false;
+		std::vector<double> departures; //отправления рейсов от первой остановки, минуты от начала суток
+		BusId id = 0; //назначается в TransportCatalogue::AddBus
 	};
 
 	struct BusInfo {
@@ -26,5 +36,5 @@ namespace catalogue {
 		double curvature = 0.0;
 	};
 
-	using StopInfo = const std::set<std::string_view>*;
+	using StopInfo = arena::Span<BusId>; //маршруты через остановку, по возрастанию названия
 }
\ No newline at end of file
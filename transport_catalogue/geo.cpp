@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
@@ -8,9 +9,62 @@ namespace geo {
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     const double dr = M_PI / 180.0;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+    // как и в ComputeDistances: у совпадающих точек косинус может округлиться чуть выше 1
+    return acos(clamp(sin(from.lat * dr) * sin(to.lat * dr)
+                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr), -1.0, 1.0))
+        * EARTH_RADIUS;
 }
 
-}  // namespace geo
\ No newline at end of file
+void CoordinatesTrig::Reserve(size_t count) {
+    sin_lat.reserve(count);
+    cos_lat.reserve(count);
+    sin_lng.reserve(count);
+    cos_lng.reserve(count);
+}
+
+void CoordinatesTrig::Add(Coordinates coordinates) {
+    const double dr = M_PI / 180.0;
+    sin_lat.push_back(std::sin(coordinates.lat * dr));
+    cos_lat.push_back(std::cos(coordinates.lat * dr));
+    sin_lng.push_back(std::sin(coordinates.lng * dr));
+    cos_lng.push_back(std::cos(coordinates.lng * dr));
+}
+
+size_t CoordinatesTrig::Size() const {
+    return sin_lat.size();
+}
+
+namespace {
+
+// Цикл без ветвлений и вызовов, а __restrict снимает возможное наложение выхода на таблицу, так что
+// компилятор может его векторизовать (GCC делает это с -O3; с -O2 и без оптимизации цикл скалярный)
+void ComputeCentralAngleCosines(const double* __restrict sin_lat, const double* __restrict cos_lat,
+    const double* __restrict sin_lng, const double* __restrict cos_lng,
+    const std::uint32_t* __restrict from, const std::uint32_t* __restrict to, double* __restrict out, size_t count) {
+    // cos(lng1 - lng2) раскрыт через кэшированные синусы и косинусы
+    for (size_t i = 0; i < count; ++i) {
+        const size_t a = from[i];
+        const size_t b = to[i];
+        const double cos_dlng = cos_lng[a] * cos_lng[b] + sin_lng[a] * sin_lng[b];
+        out[i] = sin_lat[a] * sin_lat[b] + cos_lat[a] * cos_lat[b] * cos_dlng;
+    }
+}
+
+}  // namespace
+
+void ComputeDistances(const CoordinatesTrig& points, const std::uint32_t* from, const std::uint32_t* to, size_t count, double* out) {
+    ComputeCentralAngleCosines(points.sin_lat.data(), points.cos_lat.data(), points.sin_lng.data(), points.cos_lng.data(),
+        from, to, out, count);
+    // для совпадающих точек округление может дать чуть больше 1, а acos от этого — NaN
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = std::acos(std::clamp(out[i], -1.0, 1.0)) * EARTH_RADIUS;
+    }
+}
+
+double ComputeDistance(const CoordinatesTrig& points, std::uint32_t from, std::uint32_t to) {
+    double distance = 0.0;
+    ComputeDistances(points, &from, &to, 1, &distance);
+    return distance;
+}
+
+}  // namespace geo
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 namespace geo {
 
+inline constexpr double EARTH_RADIUS = 6371000; // метры
+
 struct Coordinates {
     double lat = 0.0; // Широта
     double lng = 0.0; // Долгота
@@ -9,4 +15,24 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
-}  // namespace geo
\ No newline at end of file
+// Синусы и косинусы широты и долготы, посчитанные один раз на точку.
+// Структура массивов: элемент i каждого массива относится к точке с номером i
+struct CoordinatesTrig {
+    std::vector<double> sin_lat;
+    std::vector<double> cos_lat;
+    std::vector<double> sin_lng;
+    std::vector<double> cos_lng;
+
+    void Reserve(size_t count);
+    void Add(Coordinates coordinates);
+    size_t Size() const;
+};
+
+// out[i] — расстояние между точками from[i] и to[i] таблицы points, i < count, по той же формуле,
+// что и ComputeDistance, но без sin и cos: на пару остаётся один acos
+void ComputeDistances(const CoordinatesTrig& points, const std::uint32_t* from, const std::uint32_t* to, size_t count, double* out);
+
+// Расстояние между точками from и to таблицы points, как у ComputeDistances
+double ComputeDistance(const CoordinatesTrig& points, std::uint32_t from, std::uint32_t to);
+
+}  // namespace geo
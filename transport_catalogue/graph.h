@@ -1,8 +1,11 @@
 ﻿#pragma once
 
+#include "memory_stats.h"
 #include "ranges.h"
 
+#include <cassert>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -26,34 +29,114 @@ namespace graph {
     public:
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
+        VertexId AddVertex();
         EdgeId AddEdge(const Edge<Weight>& edge);
 
+        // Переводит граф в неизменяемое CSR-представление: рёбра каждой вершины лежат подряд
+        // в общих массивах номеров, концов и весов рёбер. Порядок рёбер вершины сохраняется,
+        // поэтому алгоритмы дают те же результаты. После заморозки AddEdge бросает исключение
+        void Freeze();
+        // Возвращает граф к спискам смежности, чтобы снова добавлять вершины и рёбра
+        void Thaw();
+        bool IsFrozen() const;
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
+        memory::MemoryStats GetMemoryStats() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+        // Вызывает callback(edge_id, edge.to, edge.weight) для каждого исходящего ребра vertex.
+        // На замороженном графе проходит по непрерывным массивам без обращения к edges_
+        template <typename Callback>
+        void ForEachIncidentEdge(VertexId vertex, Callback callback) const;
+
     private:
         std::vector<Edge<Weight>> edges_;
         std::vector<IncidenceList> incidence_lists_;
+
+        //CSR: рёбра вершины v занимают позиции [incidence_offsets_[v], incidence_offsets_[v + 1])
+        bool frozen_ = false;
+        size_t vertex_count_ = 0;
+        std::vector<size_t> incidence_offsets_;
+        IncidenceList incidence_edges_;
+        std::vector<VertexId> incidence_targets_;
+        std::vector<Weight> incidence_weights_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
+        : incidence_lists_(vertex_count)
+        , vertex_count_(vertex_count) {
+    }
+
+    template <typename Weight>
+    VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+        if (frozen_) {
+            throw std::logic_error("Can't add a vertex to a frozen graph");
+        }
+        incidence_lists_.emplace_back();
+        return vertex_count_++;
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (frozen_) {
+            throw std::logic_error("Can't add an edge to a frozen graph");
+        }
         edges_.push_back(edge);
         const EdgeId id = edges_.size() - 1;
         incidence_lists_.at(edge.from).push_back(id);
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (frozen_) {
+            return;
+        }
+        incidence_offsets_.reserve(vertex_count_ + 1);
+        incidence_edges_.reserve(edges_.size());
+        incidence_targets_.reserve(edges_.size());
+        incidence_weights_.reserve(edges_.size());
+        incidence_offsets_.push_back(0);
+        for (const IncidenceList& incidence_list : incidence_lists_) {
+            for (const EdgeId edge_id : incidence_list) {
+                incidence_edges_.push_back(edge_id);
+                incidence_targets_.push_back(edges_[edge_id].to);
+                incidence_weights_.push_back(edges_[edge_id].weight);
+            }
+            incidence_offsets_.push_back(incidence_edges_.size());
+        }
+        std::vector<IncidenceList>().swap(incidence_lists_);
+        frozen_ = true;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Thaw() {
+        if (!frozen_) {
+            return;
+        }
+        incidence_lists_.resize(vertex_count_);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            incidence_lists_[vertex].assign(incidence_edges_.begin() + incidence_offsets_[vertex],
+                incidence_edges_.begin() + incidence_offsets_[vertex + 1]);
+        }
+        IncidenceList().swap(incidence_edges_);
+        std::vector<size_t>().swap(incidence_offsets_);
+        std::vector<VertexId>().swap(incidence_targets_);
+        std::vector<Weight>().swap(incidence_weights_);
+        frozen_ = false;
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return frozen_;
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
@@ -61,14 +144,49 @@ namespace graph {
         return edges_.size();
     }
 
+    template <typename Weight>
+    memory::MemoryStats DirectedWeightedGraph<Weight>::GetMemoryStats() const {
+        return {
+            memory::Describe("edges_", edges_),
+            memory::Describe("incidence_lists_", incidence_lists_),
+            memory::Describe("incidence_offsets_", incidence_offsets_),
+            memory::Describe("incidence_edges_", incidence_edges_),
+            memory::Describe("incidence_targets_", incidence_targets_),
+            memory::Describe("incidence_weights_", incidence_weights_),
+        };
+    }
+
     template <typename Weight>
     const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-        return edges_.at(edge_id);
+        assert(edge_id < edges_.size());
+        return edges_[edge_id];
     }
 
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        assert(vertex < vertex_count_);
+        if (frozen_) {
+            return ranges::Range{ incidence_edges_.begin() + incidence_offsets_[vertex],
+                incidence_edges_.begin() + incidence_offsets_[vertex + 1] };
+        }
+        return ranges::AsRange(incidence_lists_[vertex]);
+    }
+
+    template <typename Weight>
+    template <typename Callback>
+    void DirectedWeightedGraph<Weight>::ForEachIncidentEdge(VertexId vertex, Callback callback) const {
+        assert(vertex < vertex_count_);
+        if (frozen_) {
+            const size_t end = incidence_offsets_[vertex + 1];
+            for (size_t position = incidence_offsets_[vertex]; position < end; ++position) {
+                callback(incidence_edges_[position], incidence_targets_[position], incidence_weights_[position]);
+            }
+            return;
+        }
+        for (const EdgeId edge_id : incidence_lists_[vertex]) {
+            const Edge<Weight>& edge = edges_[edge_id];
+            callback(edge_id, edge.to, edge.weight);
+        }
     }
 }  // namespace graph
\ No newline at end of file
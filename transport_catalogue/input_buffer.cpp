@@ -0,0 +1,155 @@
+#include "input_buffer.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INPUT_BUFFER_MMAP
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+
+using namespace std::literals;
+
+#ifdef INPUT_BUFFER_MMAP
+
+namespace {
+
+std::runtime_error MakeSystemError(std::string_view what) {
+    return std::runtime_error(std::string(what) + ": "s + std::strerror(errno));
+}
+
+}  // namespace
+
+InputBuffer InputBuffer::FromFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw MakeSystemError("Unable to open "s + path);
+    }
+    try {
+        InputBuffer result = FromDescriptor(fd);
+        ::close(fd);
+        return result;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+InputBuffer InputBuffer::FromStdin() {
+    return FromDescriptor(STDIN_FILENO);
+}
+
+InputBuffer InputBuffer::FromDescriptor(int fd) {
+    InputBuffer result;
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        // ввод, перенаправленный из файла, мог быть уже частично прочитан: данные — с текущей позиции
+        const off_t offset = ::lseek(fd, 0, SEEK_CUR);
+        const size_t size = static_cast<size_t>(info.st_size);
+        if (offset >= 0 && static_cast<size_t>(offset) < size) {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                // разбор идёт от начала к концу: ядро может читать с опережением
+                ::madvise(mapping, size, MADV_SEQUENTIAL);
+                result.mapping_ = mapping;
+                result.mapping_size_ = size;
+                result.data_ = std::string_view(static_cast<const char*>(mapping) + offset, size - static_cast<size_t>(offset));
+                return result;
+            }
+        }
+    }
+    // канал или терминал: читаем блоками до конца
+    char chunk[1 << 16];
+    while (true) {
+        const ssize_t count = ::read(fd, chunk, sizeof(chunk));
+        if (count > 0) {
+            result.buffer_.append(chunk, static_cast<size_t>(count));
+        } else if (count == 0) {
+            break;
+        } else if (errno != EINTR) {
+            throw MakeSystemError("Unable to read input"sv);
+        }
+    }
+    result.data_ = result.buffer_;
+    return result;
+}
+
+void InputBuffer::Unmap() {
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+}
+
+#else
+
+InputBuffer InputBuffer::FromFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Unable to open "s + path);
+    }
+    std::ostringstream buffer;
+    buffer << input.rdbuf();
+    InputBuffer result;
+    result.buffer_ = std::move(buffer).str();
+    result.data_ = result.buffer_;
+    return result;
+}
+
+InputBuffer InputBuffer::FromStdin() {
+    std::ostringstream buffer;
+    buffer << std::cin.rdbuf();
+    InputBuffer result;
+    result.buffer_ = std::move(buffer).str();
+    result.data_ = result.buffer_;
+    return result;
+}
+
+void InputBuffer::Unmap() {
+}
+
+#endif
+
+InputBuffer::InputBuffer(InputBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+InputBuffer& InputBuffer::operator=(InputBuffer&& other) noexcept {
+    if (this != &other) {
+        Unmap();
+        const bool other_owns_buffer = other.mapping_ == nullptr;
+        mapping_ = std::exchange(other.mapping_, nullptr);
+        mapping_size_ = std::exchange(other.mapping_size_, 0);
+        buffer_ = std::move(other.buffer_);
+        // при перемещении короткой строки её символы переезжают: срез надо перестроить
+        data_ = other_owns_buffer ? std::string_view(buffer_) : other.data_;
+        other.buffer_.clear();
+        other.data_ = {};
+    }
+    return *this;
+}
+
+InputBuffer::~InputBuffer() {
+    Unmap();
+}
+
+std::string_view InputBuffer::GetData() const {
+    return data_;
+}
+
+bool InputBuffer::IsMapped() const {
+    return mapping_ != nullptr;
+}
+
+}  // namespace io
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace io {
+
+    // Весь вход одним непрерывным буфером только для чтения. Обычный файл отображается в память
+    // (mmap) без копирования, остальное (канал, терминал, платформы без mmap) читается целиком в строку
+    class InputBuffer {
+    public:
+        // бросает std::runtime_error, если файл не открывается или не читается
+        static InputBuffer FromFile(const std::string& path);
+
+        // стандартный ввод; перенаправленный из файла тоже отображается в память
+        static InputBuffer FromStdin();
+
+        InputBuffer(InputBuffer&& other) noexcept;
+        InputBuffer& operator=(InputBuffer&& other) noexcept;
+        InputBuffer(const InputBuffer&) = delete;
+        InputBuffer& operator=(const InputBuffer&) = delete;
+        ~InputBuffer();
+
+        std::string_view GetData() const;
+
+        bool IsMapped() const;
+
+    private:
+        InputBuffer() = default;
+
+        // fd не закрывается: владелец у него вызывающий
+        static InputBuffer FromDescriptor(int fd);
+
+        void Unmap();
+
+        void* mapping_ = nullptr;     // начало отображения или nullptr, если данные в buffer_
+        size_t mapping_size_ = 0;
+        std::string buffer_;
+        std::string_view data_;
+    };
+
+}  // namespace io
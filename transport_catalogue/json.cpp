@@ -1,226 +1,387 @@
 #include "json.h"
 
-#include <iterator>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <sstream>
+#include <system_error>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+#ifdef JSON_SSE2
+int CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+// Разбор непрерывного буфера. Позиция — указатель в буфер, токены — его срезы: строка без escape-
+// последовательностей копируется в Node одним куском, числа читает std::from_chars. Кавычки и
+// escape-символы в строках и пробелы между токенами ищутся по 16 байт за раз (SSE2)
+class Parser {
+public:
+    explicit Parser(std::string_view input)
+        : pos_(input.data())
+        , end_(input.data() + input.size()) {
+    }
+
+    Node ParseNode() {
+        SkipWhitespace();
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (*pos_) {
+            case '[':
+                ++pos_;
+                return ParseArray();
+            case '{':
+                ++pos_;
+                return ParseDict();
+            case '"':
+                ++pos_;
+                return Node(ParseString());
+            case 't':
+                [[fallthrough]];
+            case 'f':
+                return ParseBool();
+            case 'n':
+                return ParseNull();
+            default:
+                return ParseNumber();
+        }
+    }
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+private:
+    static bool IsWhitespace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
     }
-    return s;
-}
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+    // символы, на которых кончается простой участок строки
+    static bool IsStringSpecial(char c) {
+        return c == '"' || c == '\\' || c == '\n' || c == '\r';
+    }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    void SkipWhitespace() {
+        //между токенами чаще всего нет ни одного пробела или он один
+        if (pos_ == end_ || !IsWhitespace(*pos_)) {
+            return;
+        }
+#ifdef JSON_SSE2
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i carriage_return = _mm_set1_epi8('\r');
+        const __m128i tab = _mm_set1_epi8('\t');
+        for (; end_ - pos_ >= 16; pos_ += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos_));
+            const __m128i whitespace = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newline)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_return), _mm_cmpeq_epi8(chunk, tab)));
+            const unsigned other = ~static_cast<unsigned>(_mm_movemask_epi8(whitespace)) & 0xFFFFu;
+            if (other != 0) {
+                pos_ += CountTrailingZeros(other);
+                return;
+            }
+        }
+#endif
+        while (pos_ != end_ && IsWhitespace(*pos_)) {
+            ++pos_;
         }
-        result.push_back(LoadNode(input));
-    }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
     }
-    return Node(std::move(result));
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
-
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+    // первый после pos_ символ, на котором кончается простой участок строки; end_, если такого нет
+    const char* FindStringSpecial() const {
+        const char* pos = pos_;
+#ifdef JSON_SSE2
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i newline = _mm_set1_epi8('\n');
+        const __m128i carriage_return = _mm_set1_epi8('\r');
+        for (; end_ - pos >= 16; pos += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            const __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriage_return)));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+            if (mask != 0) {
+                return pos + CountTrailingZeros(mask);
             }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
+#endif
+        while (pos != end_ && !IsStringSpecial(*pos)) {
+            ++pos;
+        }
+        return pos;
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+
+    Node ParseArray() {
+        Array result;
+        SkipWhitespace();
+        if (pos_ != end_ && *pos_ == ']') {
+            ++pos_;
+            return Node(std::move(result));
+        }
+        while (true) {
+            result.push_back(ParseNode());
+            SkipWhitespace();
+            if (pos_ == end_) {
+                throw ParsingError("Array parsing error"s);
+            }
+            const char c = *pos_++;
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        return Node(std::move(result));
     }
-    return Node(std::move(dict));
-}
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+    Node ParseDict() {
+        Dict dict;
+        SkipWhitespace();
+        if (pos_ != end_ && *pos_ == '}') {
+            ++pos_;
+            return Node(std::move(dict));
+        }
+        while (true) {
+            SkipWhitespace();
+            if (pos_ == end_) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (*pos_ != '"') {
+                throw ParsingError(R"('"' is expected but ')"s + *pos_ + "' has been found"s);
+            }
+            ++pos_;
+            std::string key = ParseString();
+            SkipWhitespace();
+            if (pos_ == end_ || *pos_ != ':') {
+                throw ParsingError(": is expected after key '"s + key + "'"s);
+            }
+            ++pos_;
+            const auto [it, inserted] = dict.try_emplace(std::move(key));
+            if (!inserted) {
+                throw ParsingError("Duplicate key '"s + it->first + "' have been found");
+            }
+            it->second = ParseNode();
+            SkipWhitespace();
+            if (pos_ == end_) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            const char c = *pos_++;
+            if (c == '}') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+        return Node(std::move(dict));
+    }
+
+    // pos_ — сразу после открывающей кавычки
+    std::string ParseString() {
+        std::string s;
+        while (true) {
+            const char* special = FindStringSpecial();
+            if (special == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
+            s.append(pos_, special);
+            pos_ = special + 1;
+            switch (*special) {
                 case '"':
-                    s.push_back('"');
-                    break;
+                    return s;
                 case '\\':
-                    s.push_back('\\');
+                    ParseEscape(s);
                     break;
                 default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                    throw ParsingError("Unexpected end of line"s);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
         }
-        ++it;
     }
 
-    return Node(std::move(s));
-}
-
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    // pos_ — сразу после обратной косой черты
+    void ParseEscape(std::string& s) {
+        if (pos_ == end_) {
+            throw ParsingError("String parsing error");
+        }
+        const char escaped_char = *pos_++;
+        switch (escaped_char) {
+            case 'n':
+                s.push_back('\n');
+                break;
+            case 't':
+                s.push_back('\t');
+                break;
+            case 'r':
+                s.push_back('\r');
+                break;
+            case 'b':
+                s.push_back('\b');
+                break;
+            case 'f':
+                s.push_back('\f');
+                break;
+            case '"':
+                [[fallthrough]];
+            case '\\':
+                [[fallthrough]];
+            case '/':
+                s.push_back(escaped_char);
+                break;
+            case 'u':
+                AppendUtf8(ParseCodePoint(), s);
+                break;
+            default:
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+        }
     }
-}
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+    // \uXXXX, а для символов вне BMP — суррогатная пара \uD8XX\uDCXX; pos_ — после "\u"
+    char32_t ParseCodePoint() {
+        const char32_t unit = ParseHex4();
+        if (unit < 0xD800 || unit > 0xDFFF) {
+            return unit;
+        }
+        if (unit > 0xDBFF || end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u') {
+            throw ParsingError("Unpaired surrogate in \\u escape sequence"s);
+        }
+        pos_ += 2;
+        const char32_t low = ParseHex4();
+        if (low < 0xDC00 || low > 0xDFFF) {
+            throw ParsingError("Unpaired surrogate in \\u escape sequence"s);
+        }
+        return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
     }
-}
-
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+    char32_t ParseHex4() {
+        unsigned value = 0;
+        const auto [ptr, ec] = std::from_chars(pos_, pos_ + std::min<std::ptrdiff_t>(4, end_ - pos_), value, 16);
+        if (ec != std::errc{} || ptr != pos_ + 4) {
+            throw ParsingError("Four hex digits are expected after \\u"s);
         }
-    };
+        pos_ = ptr;
+        return value;
+    }
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
-        }
-        while (std::isdigit(input.peek())) {
-            read_char();
+    static void AppendUtf8(char32_t code_point, std::string& s) {
+        if (code_point < 0x80) {
+            s.push_back(static_cast<char>(code_point));
+        } else if (code_point < 0x800) {
+            s.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point < 0x10000) {
+            s.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else {
+            s.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            s.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            s.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
         }
-    };
-
-    if (input.peek() == '-') {
-        read_char();
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    std::string_view ParseWord() {
+        const char* begin = pos_;
+        while (pos_ != end_ && std::isalpha(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return { begin, static_cast<size_t>(pos_ - begin) };
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    Node ParseBool() {
+        const std::string_view word = ParseWord();
+        if (word == "true"sv) {
+            return Node{true};
+        } else if (word == "false"sv) {
+            return Node{false};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(word) + "' as bool"s);
+        }
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    Node ParseNull() {
+        if (const std::string_view word = ParseWord(); word == "null"sv) {
+            return Node{nullptr};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(word) + "' as null"s);
         }
-        read_digits();
-        is_int = false;
     }
 
-    try {
+    Node ParseNumber() {
+        const char* begin = pos_;
+
+        // Пропускает одну или более цифр
+        auto skip_digits = [this] {
+            if (pos_ == end_ || !std::isdigit(static_cast<unsigned char>(*pos_))) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (pos_ != end_ && std::isdigit(static_cast<unsigned char>(*pos_))) {
+                ++pos_;
+            }
+        };
+
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
+        }
+        // После 0 в JSON не могут идти другие цифры
+        if (pos_ != end_ && *pos_ == '0') {
+            ++pos_;
+        } else {
+            skip_digits();
+        }
+
+        bool is_int = true;
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            skip_digits();
+            is_int = false;
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            skip_digits();
+            is_int = false;
+        }
+
         if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+            int value = 0;
+            // при переполнении int число читается как double
+            if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                return value;
             }
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        double value = 0.0;
+        if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec != std::errc{} || ptr != pos_) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+        }
+        return value;
     }
-}
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
-    }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
-    }
-}
+    const char* pos_;
+    const char* end_;
+};
 
 struct PrintContext {
     std::ostream& out;
@@ -340,8 +501,15 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+Document Load(std::string_view input) {
+    return Document{Parser(input).ParseNode()};
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    //поток читается целиком блоками буфера, а разбирается уже непрерывный буфер
+    std::ostringstream buffer;
+    buffer << input.rdbuf();
+    return Load(std::string_view(buffer.str()));
 }
 
 void Print(const Document& doc, std::ostream& output) {
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -139,6 +140,10 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Разбирает непрерывный буфер; строки в Node копируются, так что буфер можно освободить сразу после разбора
+Document Load(std::string_view input);
+
+// Читает поток целиком в буфер и разбирает его
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
@@ -1,8 +1,11 @@
 #include "json_reader.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <sstream>
 #include <filesystem>
+#include <iterator>
+#include <stdexcept>
 
 #include "json_builder.h"
 
@@ -11,60 +14,130 @@ namespace reader {
 using namespace json;
 using namespace std::string_literals;
 
-struct toStopDistance {
-	std::string_view from;
-	std::string_view to;
-	uint32_t distance;
-};
+namespace {
+
+//appends stops of the bus request to stops, for a non-roundtrip bus with the way back; returns is_roundtrip
+bool AppendBusStops(const catalogue::TransportCatalogue& tc, const Dict& bus_dict, std::vector<const catalogue::Stop*>& stops) {
+	const size_t begin = stops.size();
+	for (const auto& stop : bus_dict.at("stops"s).AsArray()) {
+		//pushing const Stop* pointers to bus
+		stops.push_back(tc.GetStopByName(stop.AsString()));
+	}
+	if (bus_dict.at("is_roundtrip"s).AsBool()) {
+		return true;
+	}
+	//bus isnt roundtrip -> we should add reverse bus way to stops
+	for (size_t i = stops.size(); i > begin + 1; --i) {
+		stops.push_back(stops[i - 2]);
+	}
+	return false;
+}
+
+void ApplyEditRequest(catalogue::TransportCatalogue& tc, const Dict& edit_dict) {
+	const auto& type = edit_dict.at("type"s);
+	if (type == "RemoveBus"s) {
+		tc.RemoveBus(edit_dict.at("name"s).AsString());
+	}
+	else if (type == "RemoveStop"s) {
+		tc.RemoveStop(edit_dict.at("name"s).AsString());
+	}
+	else if (type == "UpdateBus"s) {
+		std::vector<const catalogue::Stop*> stops;
+		const bool is_roundtrip = AppendBusStops(tc, edit_dict, stops);
+		tc.UpdateBusStops(edit_dict.at("name"s).AsString(), arena::Span<const catalogue::Stop*>(stops.data(), stops.size()), is_roundtrip);
+	}
+	else if (type == "UpdateDistance"s) {
+		tc.UpdateDistance(edit_dict.at("from"s).AsString(), edit_dict.at("to"s).AsString(), static_cast<uint32_t>(edit_dict.at("distance"s).AsInt()));
+	}
+}
+
+bool IsEditRequest(const Node& type) {
+	return type == "RemoveBus"s || type == "RemoveStop"s || type == "UpdateBus"s || type == "UpdateDistance"s;
+}
+
+}
 
 catalogue::TransportCatalogue ParseBaseRequests(const Node& base_req) {
 	catalogue::TransportCatalogue tc;
+	AddBaseRequests(tc, base_req);
+	return tc;
+}
+
+bool AddBaseRequests(catalogue::TransportCatalogue& tc, const Node& base_req) {
+	std::vector<catalogue::Stop> stops;
 	std::vector<const Node*> buses_req;
-	std::vector<toStopDistance> distances_;
-	//adding stops and saving distances, buses for further using
+	std::vector<const Node*> edits_req;
+	std::vector<catalogue::StopsDistance> distances;
+	//collecting stops, distances and buses, then adding each kind in one batch
 	for (const Node& node : base_req.AsArray()) {
 		const Dict& stop_dict = node.AsDict();
 		const auto& type = stop_dict.at("type"s);
 		if (type == "Stop"s) {
-			catalogue::Stop stop;
+			catalogue::Stop& stop = stops.emplace_back();
 			stop.name = stop_dict.at("name"s).AsString();
 			stop.coordinates = { stop_dict.at("latitude"s).AsDouble(), stop_dict.at("longitude"s).AsDouble() };
-			tc.AddStop(stop);
 			if (stop_dict.count("road_distances"s) != 0) {
 				for (const auto& [key, value] : stop_dict.at("road_distances"s).AsDict()) {
-					distances_.push_back({ stop_dict.at("name"s).AsString(), key, static_cast<uint32_t>(value.AsInt()) });
+					distances.push_back({ stop_dict.at("name"s).AsString(), key, static_cast<uint32_t>(value.AsInt()) });
 				}
 			}
 		}
 		else if (type == "Bus"s) {
 			buses_req.push_back(&node);
 		}
+		else if (IsEditRequest(type)) {
+			edits_req.push_back(&node);
+		}
 	}
-	//adding distances
-	for (const toStopDistance& tsd : distances_) {
-		tc.AddDistance(tsd.from, tsd.to, tsd.distance);
-	}
-	//adding buses
+	tc.AddStops(std::move(stops));
+	tc.AddDistances(distances);
+	//stops of all buses go one after another; spans are taken once the vector stops growing
+	std::vector<const catalogue::Stop*> buses_stops;
+	std::vector<size_t> buses_stops_begin;
+	std::vector<catalogue::Bus> buses;
+	buses.reserve(buses_req.size());
 	for (const Node* bus_req : buses_req) {
 		const Dict& bus_dict = bus_req->AsDict();
-		catalogue::Bus bus;
+		catalogue::Bus& bus = buses.emplace_back();
 		bus.name = bus_dict.at("name"s).AsString();
-		bus.is_roundtrip = true;
-		for (const auto& stop : bus_dict.at("stops"s).AsArray()) {
-			//pushing const Stop* pointers to bus
-			bus.stops.push_back(tc.GetStopByName(stop.AsString()));
-		}
-		if (!bus_dict.at("is_roundtrip"s).AsBool()) {
-			//bus isnt roundtrip -> we should add reverse bus way to stops
-			bus.is_roundtrip = false;
-			std::vector<const catalogue::Stop*> reverse_stops(std::next(bus.stops.rbegin(), 1), bus.stops.rend());
-			for (auto it = reverse_stops.begin(); it != reverse_stops.end(); std::advance(it, 1)) {
-				bus.stops.push_back(*it);
+		buses_stops_begin.push_back(buses_stops.size());
+		bus.is_roundtrip = AppendBusStops(tc, bus_dict, buses_stops);
+		if (bus_dict.count("departures"s) != 0) {
+			for (const auto& departure : bus_dict.at("departures"s).AsArray()) {
+				bus.departures.push_back(departure.AsDouble());
 			}
 		}
-		tc.AddBus(bus);
 	}
-	return tc;
+	buses_stops_begin.push_back(buses_stops.size());
+	for (size_t i = 0; i < buses.size(); ++i) {
+		buses[i].stops = arena::Span<const catalogue::Stop*>(buses_stops.data() + buses_stops_begin[i], buses_stops_begin[i + 1] - buses_stops_begin[i]);
+	}
+	tc.AddBuses(std::move(buses));
+	//edits go after all additions, in the order of requests
+	for (const Node* edit_req : edits_req) {
+		ApplyEditRequest(tc, edit_req->AsDict());
+	}
+	return !edits_req.empty();
+}
+
+void ApplyBaseRequests(catalogue::TransportCatalogue& tc, catalogue::transport_router::TransportRouter& tr, const Node& base_req) {
+	const size_t old_stops_count = tc.GetStops().size();
+	const size_t old_buses_count = tc.GetBuses().size();
+	if (AddBaseRequests(tc, base_req)) {
+		//the graph has edges of removed and changed buses: only a full rebuild drops them
+		tr.Rebuild(tc);
+		return;
+	}
+	std::vector<const catalogue::Stop*> new_stops;
+	for (auto it = std::next(tc.GetStops().begin(), old_stops_count); it != tc.GetStops().end(); ++it) {
+		new_stops.push_back(&*it);
+	}
+	std::vector<const catalogue::Bus*> new_buses;
+	for (auto it = std::next(tc.GetBuses().begin(), old_buses_count); it != tc.GetBuses().end(); ++it) {
+		new_buses.push_back(&*it);
+	}
+	tr.AddStops(new_stops);
+	tr.AddBuses(tc, new_buses);
 }
 
 svg::Color GetColor(const Node& color_node) {
@@ -112,104 +185,198 @@ renderer::MapRenderer ParseRenderRequests(const json::Node& render_sett) {
 	return renderer::MapRenderer(settings);
 }
 
-Document ParseStatRequests(const RequestHandler& rh, const Node& stat_req) {
-	Array out;
-	for (const Node& node : stat_req.AsArray()) {
-		const Dict& stop_dict = node.AsDict();
-		Dict dict;
-		const auto& type = stop_dict.at("type"s);
-		if (type == "Stop"s) {
-			const std::string& name = stop_dict.at("name"s).AsString();
-			if (auto stops_set = rh.GetBusesByStop(name)) {
-				Array stops_arr;
-				if (*stops_set != nullptr) {
-					for (const std::string_view stop : **stops_set) {
-						stops_arr.push_back(std::string(stop));
-					}
-				}
-				dict = json::Builder{}
-					.StartDict()
-						.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-						.Key("buses"s).Value(stops_arr)
-					.EndDict()
-					.Build().AsDict();
-			}
-			else {
-				dict = json::Builder{}
-					.StartDict()
-						.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-						.Key("error_message"s).Value("not found"s)
-					.EndDict()
-					.Build().AsDict();
-			}
-		}
-		else if (type == "Bus"s) {
-			const std::string& name = stop_dict.at("name"s).AsString();
-			if (auto bus_info = rh.GetBusStat(name)) {
-				dict = json::Builder{}
-					.StartDict()
-						.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-						.Key("curvature"s).Value((*bus_info).curvature)
-						.Key("route_length"s).Value((*bus_info).route_length)
-						.Key("stop_count"s).Value((*bus_info).stops)
-						.Key("unique_stop_count"s).Value((*bus_info).unique_stops)
-					.EndDict()
-					.Build().AsDict();
+Dict ParseStatRequest(const RequestHandler& rh, const Node& node) {
+	const Dict& stop_dict = node.AsDict();
+	Dict dict;
+	const auto& type = stop_dict.at("type"s);
+	if (type == "Stop"s) {
+		const std::string& name = stop_dict.at("name"s).AsString();
+		if (auto stop_buses = rh.GetBusesByStop(name)) {
+			Array stops_arr;
+			stops_arr.reserve(stop_buses->size());
+			for (const catalogue::BusId bus : *stop_buses) {
+				stops_arr.push_back(std::string(rh.GetBusName(bus)));
 			}
-			else {
-				dict = json::Builder{}
-					.StartDict()
-						.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-						.Key("error_message"s).Value("not found"s)
-					.EndDict()
-					.Build().AsDict();
-			}
-		}
-		else if (type == "Map"s) {
-			std::ostringstream out_stream;
-			rh.RenderMap().Render(out_stream);
 			dict = json::Builder{}
 				.StartDict()
 					.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-					.Key("map"s).Value(out_stream.str())
+					.Key("buses"s).Value(stops_arr)
 				.EndDict()
 				.Build().AsDict();
 		}
-		else if (type == "Route"s) {
-			const Node& route_info = rh.Route(stop_dict.at("from"s).AsString(), stop_dict.at("to"s).AsString());
-			if (route_info.IsNull()) {
-				dict = json::Builder{}
-					.StartDict()
+		else {
+			dict = json::Builder{}
+				.StartDict()
 					.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
 					.Key("error_message"s).Value("not found"s)
-					.EndDict().Build().AsDict();
-			}
-			else {
-				const Dict& route_dict = route_info.AsDict();
-				dict = json::Builder{}
-					.StartDict()
+				.EndDict()
+				.Build().AsDict();
+		}
+	}
+	else if (type == "Bus"s) {
+		const std::string& name = stop_dict.at("name"s).AsString();
+		if (auto bus_info = rh.GetBusStat(name)) {
+			dict = json::Builder{}
+				.StartDict()
 					.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
-					.Key("total_time"s).Value(route_dict.at("total_time"s).AsDouble())
-					.Key("items"s).Value(route_dict.at("items"s).AsArray())
-					.EndDict().Build().AsDict();
-			}
+					.Key("curvature"s).Value((*bus_info).curvature)
+					.Key("route_length"s).Value((*bus_info).route_length)
+					.Key("stop_count"s).Value((*bus_info).stops)
+					.Key("unique_stop_count"s).Value((*bus_info).unique_stops)
+				.EndDict()
+				.Build().AsDict();
 		}
 		else {
 			dict = json::Builder{}
 				.StartDict()
 					.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+					.Key("error_message"s).Value("not found"s)
 				.EndDict()
 				.Build().AsDict();
 		}
-		out.push_back(dict);
+	}
+	else if (type == "Map"s) {
+		std::ostringstream out_stream;
+		rh.RenderMap().Render(out_stream);
+		dict = json::Builder{}
+			.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+				.Key("map"s).Value(out_stream.str())
+			.EndDict()
+			.Build().AsDict();
+	}
+	else if (type == "Route"s) {
+		//с departure_time маршрут строится по расписанию, иначе — с постоянным bus_wait_time
+		const Node& route_info = stop_dict.count("departure_time"s) != 0
+			? rh.Route(stop_dict.at("from"s).AsString(), stop_dict.at("to"s).AsString(), stop_dict.at("departure_time"s).AsDouble())
+			: rh.Route(stop_dict.at("from"s).AsString(), stop_dict.at("to"s).AsString());
+		if (route_info.IsNull()) {
+			dict = json::Builder{}
+				.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+				.Key("error_message"s).Value("not found"s)
+				.EndDict().Build().AsDict();
+		}
+		else {
+			const Dict& route_dict = route_info.AsDict();
+			dict = json::Builder{}
+				.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+				.Key("total_time"s).Value(route_dict.at("total_time"s).AsDouble())
+				.Key("items"s).Value(route_dict.at("items"s).AsArray())
+				.EndDict().Build().AsDict();
+		}
+	}
+	else if (type == "Matrix"s) {
+		std::vector<std::string_view> from, to;
+		for (const Node& stop : stop_dict.at("from"s).AsArray()) {
+			from.push_back(stop.AsString());
+		}
+		for (const Node& stop : stop_dict.at("to"s).AsArray()) {
+			to.push_back(stop.AsString());
+		}
+		Node times = rh.Matrix(from, to);
+		if (times.IsNull()) {
+			dict = json::Builder{}
+				.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+				.Key("error_message"s).Value("not found"s)
+				.EndDict().Build().AsDict();
+		}
+		else {
+			//матрица может быть большой, поэтому переносим её в ответ без копирования
+			dict.emplace("request_id"s, stop_dict.at("id"s).AsInt());
+			dict.emplace("times"s, std::move(times));
+		}
+	}
+	else if (type == "Isochrone"s) {
+		Node stops = rh.Isochrone(stop_dict.at("from"s).AsString(), stop_dict.at("max_time"s).AsDouble());
+		if (stops.IsNull()) {
+			dict = json::Builder{}
+				.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+				.Key("error_message"s).Value("not found"s)
+				.EndDict().Build().AsDict();
+		}
+		else {
+			dict.emplace("request_id"s, stop_dict.at("id"s).AsInt());
+			dict.emplace("stops"s, std::move(stops));
+		}
+	}
+	else if (type == "Stats"s) {
+		dict = rh.Stats().AsDict();
+		dict.emplace("request_id"s, stop_dict.at("id"s).AsInt());
+	}
+	else if (type == "NearestStops"s || type == "StopsInRadius"s) {
+		const geo::Coordinates point{ stop_dict.at("latitude"s).AsDouble(), stop_dict.at("longitude"s).AsDouble() };
+		Node stops = type == "NearestStops"s
+			? rh.NearestStops(point, static_cast<size_t>(std::max(0, stop_dict.at("count"s).AsInt())))
+			: rh.StopsInRadius(point, stop_dict.at("radius"s).AsDouble());
+		dict.emplace("request_id"s, stop_dict.at("id"s).AsInt());
+		dict.emplace("stops"s, std::move(stops));
+	}
+	else {
+		dict = json::Builder{}
+			.StartDict()
+				.Key("request_id"s).Value(stop_dict.at("id"s).AsInt())
+			.EndDict()
+			.Build().AsDict();
+	}
+	return dict;
+}
+
+Document ParseStatRequests(const RequestHandler& rh, const Node& stat_req) {
+	Array out;
+	for (const Node& node : stat_req.AsArray()) {
+		out.push_back(ParseStatRequest(rh, node));
 	}
 	return Document{ out };
 }
 
 catalogue::transport_router::TransportRouter ParseRoutingSettingsRequest(const catalogue::TransportCatalogue& tc, const json::Node& routing_settings) {
+	using catalogue::transport_router::RouterType;
+	using catalogue::transport_router::GraphModel;
 	const Dict& settings = routing_settings.AsDict();
-	double bus_velocity_at_meters_min = settings.at("bus_velocity"s).AsDouble() * 1000.0 / 60.0;
-	return catalogue::transport_router::MakeTransportRouter(tc, settings.at("bus_wait_time"s).AsDouble(), bus_velocity_at_meters_min);
+	catalogue::transport_router::RoutingSettings routing;
+	routing.bus_wait_time = settings.at("bus_wait_time"s).AsDouble();
+	routing.bus_velocity = settings.at("bus_velocity"s).AsDouble() * 1000.0 / 60.0; //km/h -> m/min
+	if (settings.count("router_type"s) != 0) {
+		const std::string& router_type = settings.at("router_type"s).AsString();
+		if (router_type == "all_pairs"s) {
+			routing.router_type = RouterType::ALL_PAIRS;
+		}
+		else if (router_type == "dijkstra"s) {
+			routing.router_type = RouterType::DIJKSTRA;
+		}
+		else if (router_type == "contraction_hierarchies"s) {
+			routing.router_type = RouterType::CONTRACTION_HIERARCHIES;
+		}
+		else if (router_type == "a_star"s) {
+			routing.router_type = RouterType::A_STAR;
+		}
+		else {
+			throw std::invalid_argument("Unknown router_type: "s + router_type);
+		}
+	}
+	if (settings.count("graph_model"s) != 0) {
+		const std::string& graph_model = settings.at("graph_model"s).AsString();
+		if (graph_model == "stop_pairs"s) {
+			routing.graph_model = GraphModel::STOP_PAIRS;
+		}
+		else if (graph_model == "transit"s) {
+			routing.graph_model = GraphModel::TRANSIT;
+		}
+		else {
+			throw std::invalid_argument("Unknown graph_model: "s + graph_model);
+		}
+	}
+	if (settings.count("router_threads"s) != 0) {
+		routing.router_threads = static_cast<size_t>(settings.at("router_threads"s).AsInt());
+	}
+	if (settings.count("route_cache_capacity"s) != 0) {
+		routing.route_cache_capacity = static_cast<size_t>(settings.at("route_cache_capacity"s).AsInt());
+	}
+	return catalogue::transport_router::MakeTransportRouter(tc, routing);
 }
 
 catalogue::Serialization ParseSerializationSettings(const json::Node& ser_sett) {
@@ -10,8 +10,19 @@ namespace reader {
 
 catalogue::TransportCatalogue ParseBaseRequests(const json::Node& base_req);
 
+//adds stops, distances and buses from base_req to an existing catalogue, then applies
+//RemoveBus, RemoveStop, UpdateBus and UpdateDistance requests in order; returns true if there were any
+bool AddBaseRequests(catalogue::TransportCatalogue& tc, const json::Node& base_req);
+
+//AddBaseRequests plus adding the new stops and buses to a router built over tc;
+//after edits the router is rebuilt from tc
+void ApplyBaseRequests(catalogue::TransportCatalogue& tc, catalogue::transport_router::TransportRouter& tr, const json::Node& base_req);
+
 renderer::MapRenderer ParseRenderRequests(const json::Node& render_sett);
 
+//answer to a single stat request
+json::Dict ParseStatRequest(const RequestHandler& rh, const json::Node& request);
+
 json::Document ParseStatRequests(const RequestHandler& rh, const json::Node& stat_req);
 
 catalogue::transport_router::TransportRouter ParseRoutingSettingsRequest(const catalogue::TransportCatalogue& tc, const json::Node& routing_settings);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+    // Потокобезопасный кэш ограниченного размера с вытеснением давно не использованных
+    // записей (LRU). Значения хранятся через shared_ptr, чтобы читатель мог пользоваться
+    // значением после того, как отпустил блокировку, даже если запись уже вытеснена
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache {
+    public:
+        struct Stats {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t size = 0;
+            size_t capacity = 0;
+        };
+
+        explicit LruCache(size_t capacity)
+            : capacity_(capacity) {
+        }
+
+        // nullptr, если значения нет; обращение учитывается в счётчиках попаданий и промахов
+        std::shared_ptr<const Value> Get(const Key& key) {
+            std::lock_guard lock(mutex_);
+            const auto it = index_.find(key);
+            if (it == index_.end()) {
+                ++misses_;
+                return nullptr;
+            }
+            ++hits_;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->second;
+        }
+
+        void Put(const Key& key, Value value) {
+            if (capacity_ == 0) {
+                return;
+            }
+            auto value_ptr = std::make_shared<const Value>(std::move(value));
+            std::lock_guard lock(mutex_);
+            if (const auto it = index_.find(key); it != index_.end()) {
+                it->second->second = std::move(value_ptr);
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return;
+            }
+            if (entries_.size() == capacity_) {
+                index_.erase(entries_.back().first);
+                entries_.pop_back();
+            }
+            entries_.emplace_front(key, std::move(value_ptr));
+            index_.emplace(key, entries_.begin());
+        }
+
+        //сбрасывает все записи, например когда сохранённые значения устарели; счётчики сохраняются
+        void Clear() {
+            std::lock_guard lock(mutex_);
+            index_.clear();
+            entries_.clear();
+        }
+
+        size_t GetCapacity() const {
+            return capacity_;
+        }
+
+        Stats GetStats() const {
+            std::lock_guard lock(mutex_);
+            return { hits_, misses_, entries_.size(), capacity_ };
+        }
+
+        // Оценка памяти записей: узлы списка и индекса, значения с блоком shared_ptr
+        // и собственная память значения, которую считает value_bytes(const Value&)
+        template <typename ValueBytes>
+        size_t GetBytes(ValueBytes value_bytes) const {
+            std::lock_guard lock(mutex_);
+            size_t bytes = index_.bucket_count() * sizeof(void*);
+            for (const Entry& entry : entries_) {
+                bytes += sizeof(Entry) + 2 * sizeof(void*)
+                    + sizeof(typename decltype(index_)::value_type) + sizeof(void*) + sizeof(size_t)
+                    + sizeof(Value) + 2 * sizeof(long)
+                    + value_bytes(*entry.second);
+            }
+            return bytes;
+        }
+
+    private:
+        using Entry = std::pair<Key, std::shared_ptr<const Value>>;
+
+        mutable std::mutex mutex_;
+        const size_t capacity_;
+        std::list<Entry> entries_; //в начале — последние использованные
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+    };
+
+}  // namespace cache
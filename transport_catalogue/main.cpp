@@ -3,36 +3,94 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "timetable_router.h"
+#include "catalogue_snapshot.h"
+#include "memory_stats.h"
+#include "input_buffer.h"
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <string>
 #include <string_view>
 #include <optional>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests] [--stats] [--input=FILE]\n"sv;
+}
+
+//--stats: память справочника и маршрутизатора по контейнерам, в stderr
+void PrintMemoryStats(const catalogue::TransportCatalogue& tc, const catalogue::transport_router::TransportRouter& tr) {
+    memory::Print(std::cerr, "catalogue"sv, tc.GetMemoryStats());
+    memory::Print(std::cerr, "router"sv, tr.GetMemoryStats());
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
-
     const std::string_view mode(argv[1]);
 
-    json::Document doc = json::Load(std::cin);
+    bool print_stats = false;
+    std::optional<std::string> input_path; //без --input запросы читаются из stdin
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--stats"sv) {
+            print_stats = true;
+        }
+        else if (arg.substr(0, "--input="sv.size()) == "--input="sv) {
+            input_path = std::string(arg.substr("--input="sv.size()));
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    //вход разбирается прямо из отображённого в память файла; после разбора буфер не нужен
+    json::Document doc = [&input_path] {
+        const io::InputBuffer input = input_path ? io::InputBuffer::FromFile(*input_path) : io::InputBuffer::FromStdin();
+        return json::Load(input.GetData());
+    }();
 
     if (mode == "make_base"sv) {
         const catalogue::TransportCatalogue& tc = reader::ParseBaseRequests(doc.GetRoot().AsDict().at("base_requests"s));
         const renderer::MapRenderer& mr = reader::ParseRenderRequests(doc.GetRoot().AsDict().at("render_settings"s));
         const catalogue::transport_router::TransportRouter& tr = reader::ParseRoutingSettingsRequest(tc, doc.GetRoot().AsDict().at("routing_settings"s));
+        if (const auto* router = tr.GetTransportRouterData().router) {
+            std::cerr << "Router built in "sv << std::chrono::duration_cast<std::chrono::milliseconds>(router->GetBuildTime()).count() << " ms ("sv << graph::GetRelaxRowKernelName() << ")\n"sv;
+        }
         const catalogue::Serialization& serializer = reader::ParseSerializationSettings(doc.GetRoot().AsDict().at("serialization_settings"s));
         serializer.SerializeCatalogue(tc, mr, tr);
+        if (print_stats) {
+            PrintMemoryStats(tc, tr);
+        }
     } 
+    else if (mode == "update_base"sv) {
+        //дописывает новые остановки и маршруты в готовую базу без полного перестроения маршрутизатора;
+        //после правок (RemoveBus, UpdateBus и т.п.) маршрутизатор строится заново
+        const catalogue::Serialization& serializer = reader::ParseSerializationSettings(doc.GetRoot().AsDict().at("serialization_settings"s));
+        auto data = serializer.DeserializeCatalogue();
+        if (!data) {
+            std::cerr << "Unable to deserialize DATABASE" << std::endl;
+            return 2;
+        }
+        catalogue::TransportCatalogue& tc = data->transport_catalogue;
+        catalogue::transport_router::TransportRouter tr(data->router_settings.graph, data->router_settings.routes_internal_data, data->router_settings.contraction_hierarchy, data->router_settings.stop_vertex_id, data->router_settings.vertex_id_stop, data->router_settings.edges_extra_info, data->router_settings.routing_settings);
+        reader::ApplyBaseRequests(tc, tr, doc.GetRoot().AsDict().at("base_requests"s));
+        std::cerr << "Router updated in "sv << std::chrono::duration_cast<std::chrono::milliseconds>(tr.GetLastUpdateTime()).count() << " ms\n"sv;
+        serializer.SerializeCatalogue(tc, data->map_renderer, tr);
+        if (print_stats) {
+            PrintMemoryStats(tc, tr);
+        }
+    }
     else if (mode == "process_requests"sv) {
         const catalogue::Serialization& serializer = reader::ParseSerializationSettings(doc.GetRoot().AsDict().at("serialization_settings"s));
         auto data = serializer.DeserializeCatalogue();
@@ -40,10 +98,14 @@ int main(int argc, char* argv[]) {
             std::cerr << "Unable to deserialize DATABASE" << std::endl;
             return 2;
         }
-        //DEFAULT ROUTER FOR THIS TASK
-        const catalogue::transport_router::TransportRouter tr(data->router_settings.graph, data->router_settings.routes_internal_data, data->router_settings.stop_vertex_id, data->router_settings.vertex_id_stop, data->router_settings.edges_extra_info, data->router_settings.bus_wait_time);
-        json::Document out = reader::ParseStatRequests({ data->transport_catalogue, data->map_renderer, tr }, doc.GetRoot().AsDict().at("stat_requests"s));
+        //запросы Update подменяют базу в памяти, не прерывая ответы на остальные
+        catalogue::LiveCatalogue live_catalogue(std::move(*data));
+        json::Document out = live_catalogue.ProcessStatRequests(doc.GetRoot().AsDict().at("stat_requests"s));
         json::Print(out, std::cout);
+        if (print_stats) {
+            const catalogue::LiveCatalogue::Reader snapshot = live_catalogue.Read();
+            PrintMemoryStats(snapshot->GetCatalogue(), snapshot->GetRouter());
+        }
     } 
     else {
         PrintUsage();
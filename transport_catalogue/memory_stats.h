@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace memory {
+
+    // Память одного внутреннего контейнера: число элементов и занятые байты вместе с запасом ёмкости.
+    // Байты — оценка: служебные узлы хеш-таблиц и блоки deque считаются по типичной реализации
+    struct ContainerStats {
+        std::string name;
+        size_t elements = 0;
+        size_t bytes = 0;
+    };
+
+    using MemoryStats = std::vector<ContainerStats>;
+
+    template <typename T>
+    size_t GetBytes(const std::vector<T>& values) {
+        return values.capacity() * sizeof(T);
+    }
+
+    inline size_t GetBytes(const std::vector<bool>& values) {
+        return (values.capacity() + 7) / 8;
+    }
+
+    template <typename T>
+    size_t GetBytes(const std::vector<std::vector<T>>& values) {
+        size_t bytes = values.capacity() * sizeof(std::vector<T>);
+        for (const std::vector<T>& inner : values) {
+            bytes += GetBytes(inner);
+        }
+        return bytes;
+    }
+
+    template <typename T>
+    size_t GetBytes(const std::deque<T>& values) {
+        return values.size() * sizeof(T);
+    }
+
+    // узел: значение и указатель на следующий узел, плюс сохранённый хеш; корзина — указатель
+    template <typename Key, typename Value, typename Hash>
+    size_t GetBytes(const std::unordered_map<Key, Value, Hash>& values) {
+        return values.size() * (sizeof(std::pair<const Key, Value>) + sizeof(void*) + sizeof(size_t))
+            + values.bucket_count() * sizeof(void*);
+    }
+
+    // короткие строки хранятся внутри объекта и отдельной памяти не занимают
+    inline size_t GetHeapBytes(const std::string& value) {
+        return value.capacity() > std::string().capacity() ? value.capacity() + 1 : 0;
+    }
+
+    template <typename Container>
+    ContainerStats Describe(std::string name, const Container& values) {
+        return { std::move(name), values.size(), GetBytes(values) };
+    }
+
+    // добавляет к stats записи вложенного объекта, приписывая к их названиям prefix
+    inline void Append(MemoryStats& stats, std::string_view prefix, const MemoryStats& nested) {
+        for (const ContainerStats& container : nested) {
+            stats.push_back({ std::string(prefix) + container.name, container.elements, container.bytes });
+        }
+    }
+
+    inline size_t GetTotalBytes(const MemoryStats& stats) {
+        size_t bytes = 0;
+        for (const ContainerStats& container : stats) {
+            bytes += container.bytes;
+        }
+        return bytes;
+    }
+
+    // таблица для людей: контейнер, элементы, байты и итог
+    inline void Print(std::ostream& out, std::string_view title, const MemoryStats& stats) {
+        using namespace std::literals;
+        out << title << ": "sv << GetTotalBytes(stats) << " bytes\n"sv;
+        for (const ContainerStats& container : stats) {
+            out << "  "sv << std::left << std::setw(40) << container.name << std::right
+                << std::setw(12) << container.elements << std::setw(16) << container.bytes << '\n';
+        }
+    }
+
+}  // namespace memory
@@ -0,0 +1,144 @@
+#include "relax_kernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RELAX_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define RELAX_KERNEL_TARGET(isa)
+#else
+#define RELAX_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace graph {
+
+    namespace {
+
+        using RelaxRowFunction = void (*)(double, std::uint32_t, const double*, const std::uint32_t*,
+            double*, std::uint32_t*, size_t, std::uint32_t);
+
+        struct RelaxRowKernel {
+            RelaxRowFunction function;
+            std::string_view name;
+        };
+
+        void RelaxRowDefault(double weight_from, std::uint32_t prev_edge_from, const double* weights_through,
+            const std::uint32_t* prev_edges_through, double* weights, std::uint32_t* prev_edges, size_t count, std::uint32_t no_edge) {
+            RelaxRowScalar(weight_from, prev_edge_from, weights_through, prev_edges_through, weights, prev_edges, count, no_edge);
+        }
+
+#ifdef RELAX_KERNEL_X86
+        RELAX_KERNEL_TARGET("sse2")
+        void RelaxRowSse2(double weight_from, std::uint32_t prev_edge_from, const double* weights_through,
+            const std::uint32_t* prev_edges_through, double* weights, std::uint32_t* prev_edges, size_t count, std::uint32_t no_edge) {
+            const __m128d weight_from_x2 = _mm_set1_pd(weight_from);
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                const __m128d candidate = _mm_add_pd(weight_from_x2, _mm_loadu_pd(weights_through + i));
+                const __m128d current = _mm_loadu_pd(weights + i);
+                const int improved = _mm_movemask_pd(_mm_cmplt_pd(candidate, current));
+                if (improved == 0) {
+                    continue;
+                }
+                //улучшения редки, поэтому обновляем только изменившиеся элементы
+                for (int lane = 0; lane < 2; ++lane) {
+                    if (improved & (1 << lane)) {
+                        weights[i + lane] = weight_from + weights_through[i + lane];
+                        prev_edges[i + lane] = prev_edges_through[i + lane] != no_edge ? prev_edges_through[i + lane] : prev_edge_from;
+                    }
+                }
+            }
+            RelaxRowScalar(weight_from, prev_edge_from, weights_through + i, prev_edges_through + i,
+                weights + i, prev_edges + i, count - i, no_edge);
+        }
+
+        RELAX_KERNEL_TARGET("avx2")
+        void RelaxRowAvx2(double weight_from, std::uint32_t prev_edge_from, const double* weights_through,
+            const std::uint32_t* prev_edges_through, double* weights, std::uint32_t* prev_edges, size_t count, std::uint32_t no_edge) {
+            const __m256d weight_from_x4 = _mm256_set1_pd(weight_from);
+            const __m128i prev_edge_from_x4 = _mm_set1_epi32(static_cast<int>(prev_edge_from));
+            const __m128i no_edge_x4 = _mm_set1_epi32(static_cast<int>(no_edge));
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m256d candidate = _mm256_add_pd(weight_from_x4, _mm256_loadu_pd(weights_through + i));
+                const __m256d current = _mm256_loadu_pd(weights + i);
+                const __m256d improved = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+                if (_mm256_movemask_pd(improved) == 0) {
+                    continue;
+                }
+                _mm256_storeu_pd(weights + i, _mm256_blendv_pd(current, candidate, improved));
+
+                //маска из четырёх 64-битных элементов -> четыре 32-битных для номеров рёбер
+                const __m256i improved_64 = _mm256_castpd_si256(improved);
+                const __m128i improved_32 = _mm_castps_si128(_mm_shuffle_ps(
+                    _mm_castsi128_ps(_mm256_castsi256_si128(improved_64)),
+                    _mm_castsi128_ps(_mm256_extracti128_si256(improved_64, 1)),
+                    _MM_SHUFFLE(2, 0, 2, 0)));
+                const __m128i edges_through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + i));
+                const __m128i new_edges = _mm_blendv_epi8(edges_through, prev_edge_from_x4, _mm_cmpeq_epi32(edges_through, no_edge_x4));
+                const __m128i current_edges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + i), _mm_blendv_epi8(current_edges, new_edges, improved_32));
+            }
+            RelaxRowScalar(weight_from, prev_edge_from, weights_through + i, prev_edges_through + i,
+                weights + i, prev_edges + i, count - i, no_edge);
+        }
+
+        bool CpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuid(info, 1);
+            const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            return os_saves_ymm && (info[1] & (1 << 5));
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        bool CpuSupportsSse2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 1);
+            return info[3] & (1 << 26);
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+#endif
+
+        RelaxRowKernel SelectRelaxRowKernel() {
+#ifdef RELAX_KERNEL_X86
+            if (CpuSupportsAvx2()) {
+                return { RelaxRowAvx2, "avx2" };
+            }
+            if (CpuSupportsSse2()) {
+                return { RelaxRowSse2, "sse2" };
+            }
+#endif
+            return { RelaxRowDefault, "scalar" };
+        }
+
+        const RelaxRowKernel& GetRelaxRowKernel() {
+            static const RelaxRowKernel kernel = SelectRelaxRowKernel();
+            return kernel;
+        }
+
+    }  // namespace
+
+    void RelaxRow(double weight_from, std::uint32_t prev_edge_from, const double* weights_through,
+        const std::uint32_t* prev_edges_through, double* weights, std::uint32_t* prev_edges, size_t count, std::uint32_t no_edge) {
+        GetRelaxRowKernel().function(weight_from, prev_edge_from, weights_through, prev_edges_through, weights, prev_edges, count, no_edge);
+    }
+
+    std::string_view GetRelaxRowKernelName() {
+        return GetRelaxRowKernel().name;
+    }
+
+}  // namespace graph
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace graph {
+
+    // Релаксация строки таблицы Router через промежуточную вершину (min-plus):
+    // для каждого j, если weight_from + weights_through[j] < weights[j], то
+    // weights[j] = weight_from + weights_through[j], а prev_edges[j] =
+    // prev_edges_through[j], либо prev_edge_from, если prev_edges_through[j] == no_edge
+    template <typename Weight, typename EdgeId>
+    void RelaxRowScalar(Weight weight_from, EdgeId prev_edge_from, const Weight* weights_through,
+        const EdgeId* prev_edges_through, Weight* weights, EdgeId* prev_edges, size_t count, EdgeId no_edge) {
+        for (size_t i = 0; i < count; ++i) {
+            const Weight candidate_weight = weight_from + weights_through[i];
+            if (candidate_weight < weights[i]) {
+                weights[i] = candidate_weight;
+                prev_edges[i] = prev_edges_through[i] != no_edge ? prev_edges_through[i] : prev_edge_from;
+            }
+        }
+    }
+
+    // То же для double: реализация (AVX2, SSE2 или скалярная) выбирается один раз
+    // при первом вызове по возможностям процессора. Результат побитово совпадает с RelaxRowScalar
+    void RelaxRow(double weight_from, std::uint32_t prev_edge_from, const double* weights_through,
+        const std::uint32_t* prev_edges_through, double* weights, std::uint32_t* prev_edges, size_t count, std::uint32_t no_edge);
+
+    // "avx2", "sse2" или "scalar"
+    std::string_view GetRelaxRowKernelName();
+
+}  // namespace graph
@@ -1,49 +1,95 @@
 #include "request_handler.h"
 
-#include <set>
+#include <algorithm>
+#include <limits>
 #include <string_view>
+#include <utility>
 #include "json_builder.h"
 
-RequestHandler::RequestHandler(const catalogue::TransportCatalogue& db, const renderer::MapRenderer& renderer, const catalogue::transport_router::TransportRouter& router) 
+RequestHandler::RequestHandler(const catalogue::TransportCatalogue& db, const renderer::MapRenderer& renderer, const catalogue::transport_router::TransportRouter& router, const catalogue::timetable_router::TimetableRouter& timetable_router, const catalogue::StopsIndex& stops_index) 
 	: db_(db)
 	, renderer_(renderer)
-	, router_(router) {
+	, router_(router)
+	, timetable_router_(timetable_router)
+	, stops_index_(stops_index) {
 }
 
 const catalogue::BusInfo* RequestHandler::GetBusStat(std::string_view bus_name) const {
-	return db_.GetBusInfo(bus_name);
+	const std::optional<catalogue::BusId> bus = db_.FindBusId(bus_name);
+	if (!bus) {
+		return nullptr;
+	}
+	return &db_.GetBusInfo(*bus);
 }
 
 std::optional<catalogue::StopInfo> RequestHandler::GetBusesByStop(std::string_view stop_name) const
 {
-	return db_.GetStopInfo(stop_name);
+	const std::optional<catalogue::StopId> stop = db_.FindStopId(stop_name);
+	if (!stop) {
+		return std::nullopt;
+	}
+	return db_.GetStopInfo(*stop);
+}
+
+std::string_view RequestHandler::GetBusName(catalogue::BusId bus) const
+{
+	return db_.GetBus(bus).name;
+}
+
+bool RequestHandler::FindStopIds(const std::vector<std::string_view>& stop_names, std::vector<catalogue::StopId>& stop_ids) const
+{
+	stop_ids.clear();
+	stop_ids.reserve(stop_names.size());
+	for (std::string_view stop_name : stop_names) {
+		const std::optional<catalogue::StopId> stop = db_.FindStopId(stop_name);
+		if (!stop) {
+			return false;
+		}
+		stop_ids.push_back(*stop);
+	}
+	return true;
 }
 
 svg::Document RequestHandler::RenderMap() const
 {
 	svg::Document map;
 	//buses to out
-	std::set<std::string_view> buses_names;
+	const auto by_name = [](const auto* lhs, const auto* rhs) {
+		return lhs->name < rhs->name;
+	};
+	//одно название — одна запись: при повторе названия рисуем ту, что находится по имени
+	const auto sort_unique_by_name = [&by_name](auto& values, const auto& find_by_name) {
+		std::sort(values.begin(), values.end(), by_name);
+		values.erase(std::unique(values.begin(), values.end(), [](const auto* lhs, const auto* rhs) {
+			return lhs->name == rhs->name;
+		}), values.end());
+		for (auto& value : values) {
+			value = find_by_name(value->name);
+		}
+	};
+	std::vector<const catalogue::Bus*> buses;
 	for (const auto& bus : db_.GetBuses()) {
 		if (bus.stops.size() != 0) {
-			buses_names.insert(bus.name);
+			buses.push_back(&bus);
 		}
 	}
-	//stop_points to compute projector and stop_names to render circles
+	sort_unique_by_name(buses, [this](std::string_view name) { return db_.GetBusByName(name); });
+	//stop_points to compute projector and stops to render circles
 	std::vector<geo::Coordinates> stop_coord;
-	std::set<std::string_view> stop_names;
+	std::vector<const catalogue::Stop*> stops;
 	for (const auto& stop : db_.GetStops()) {
-		if (db_.GetStopInfo(stop.name) != nullptr) {
+		if (!db_.GetStopInfo(stop.id).empty()) {
 			stop_coord.push_back(stop.coordinates);
-			stop_names.insert(stop.name);
+			stops.push_back(&stop);
 		}
 	}
+	sort_unique_by_name(stops, [this](std::string_view name) { return db_.GetStopByName(name); });
 	renderer::Projector projector(stop_coord.begin(), stop_coord.end(), renderer_.GetWidth(), renderer_.GetHeight(), renderer_.GetPadding());
 	//out bus lines
 	int bus_number = 0;
-	for (std::string_view bus_name : buses_names) {
+	for (const catalogue::Bus* bus : buses) {
 		std::vector<svg::Point> points;
-		for (const catalogue::Stop* stop : db_.GetBusByName(bus_name)->stops) {
+		for (const catalogue::Stop* stop : bus->stops) {
 			points.push_back(projector(stop->coordinates));
 		}
 		map.Add(renderer_.RenderPolyline(points, bus_number));
@@ -51,8 +97,8 @@ svg::Document RequestHandler::RenderMap() const
 	}
 	//out ending stations names
 	bus_number = 0;
-	for (std::string_view bus_name : buses_names) {
-		const auto& bus = db_.GetBusByName(bus_name);
+	for (const catalogue::Bus* bus : buses) {
+		const std::string_view bus_name = bus->name;
 		if (bus->is_roundtrip) {
 			const catalogue::Stop* ending = bus->stops.front();
 			map.Add(renderer_.RenderTextSubstrate(projector(ending->coordinates), bus_name));
@@ -74,15 +120,15 @@ svg::Document RequestHandler::RenderMap() const
 		bus_number++;
 	}
 	//out stop's round
-	for (std::string_view stop_name : stop_names) {
-		svg::Point pos = projector(db_.GetStopByName(stop_name)->coordinates);
+	for (const catalogue::Stop* stop : stops) {
+		svg::Point pos = projector(stop->coordinates);
 		map.Add(renderer_.RenderStopCircle(pos));
 	}
 	//out stop's names
-	for (std::string_view stop_name : stop_names) {
-		svg::Point pos = projector(db_.GetStopByName(stop_name)->coordinates);
-		map.Add(renderer_.RenderStopTextSubstrate(pos, stop_name));
-		map.Add(renderer_.RenderStopText(pos, stop_name));
+	for (const catalogue::Stop* stop : stops) {
+		svg::Point pos = projector(stop->coordinates);
+		map.Add(renderer_.RenderStopTextSubstrate(pos, stop->name));
+		map.Add(renderer_.RenderStopText(pos, stop->name));
 	}
 	return map;
 }
@@ -96,27 +142,185 @@ json::Node RequestHandler::Route(std::string_view from, std::string_view to) con
 			.Key("items"s).StartArray().EndArray()
 			.EndDict().Build();
 	}
-	std::optional<catalogue::transport_router::BuiltRoute> built_route = router_.Route(from, to);
+	const std::optional<catalogue::StopId> from_stop = db_.FindStopId(from);
+	const std::optional<catalogue::StopId> to_stop = db_.FindStopId(to);
+	// переиспользуется между запросами Route, чтобы не выделять память на каждый маршрут;
+	// у каждого потока свой: один RequestHandler могут одновременно читать несколько потоков
+	thread_local catalogue::transport_router::RouteView route_buffer;
+	if (!from_stop || !to_stop || !router_.Route(*from_stop, *to_stop, route_buffer)) {
+		return json::Node();
+	}
+	return RouteToJson(route_buffer);
+}
+
+json::Node RequestHandler::Route(std::string_view from, std::string_view to, double departure_time) const
+{
+	const std::optional<catalogue::StopId> from_stop = db_.FindStopId(from);
+	const std::optional<catalogue::StopId> to_stop = db_.FindStopId(to);
+	if (!from_stop || !to_stop) {
+		return json::Node();
+	}
+	std::optional<catalogue::transport_router::BuiltRoute> built_route = timetable_router_.Route(*from_stop, *to_stop, departure_time);
 	if (!built_route) {
 		return json::Node();
 	}
+	return RouteToJson(*built_route);
+}
+
+json::Node RequestHandler::RouteToJson(const catalogue::transport_router::BuiltRoute& built_route)
+{
+	using namespace std::string_literals;
 	json::Array out;
 
-	for (size_t i = 0; i < built_route->wait_items.size(); ++i) {
+	for (size_t i = 0; i < built_route.wait_items.size(); ++i) {
 		out.push_back(json::Builder{}.StartDict()
 			.Key("type"s).Value("Wait"s)
-			.Key("stop_name").Value(built_route->wait_items[i].name)
-			.Key("time"s).Value(built_route->wait_items[i].time)
+			.Key("stop_name").Value(built_route.wait_items[i].name)
+			.Key("time"s).Value(built_route.wait_items[i].time)
 			.EndDict().Build().AsDict());
 		out.push_back(json::Builder{}.StartDict()
 			.Key("type"s).Value("Bus"s)
-			.Key("bus"s).Value(built_route->bus_items[i].name)
-			.Key("span_count"s).Value(built_route->bus_items[i].span_count)
-			.Key("time"s).Value(built_route->bus_items[i].time)
+			.Key("bus"s).Value(built_route.bus_items[i].name)
+			.Key("span_count"s).Value(built_route.bus_items[i].span_count)
+			.Key("time"s).Value(built_route.bus_items[i].time)
 			.EndDict().Build().AsDict());
 	}
 	return json::Builder{}.StartDict()
-		.Key("total_time"s).Value(built_route->total_time)
+		.Key("total_time"s).Value(built_route.total_time)
 		.Key("items"s).Value(out)
 		.EndDict().Build();
 }
+
+json::Node RequestHandler::RouteToJson(const catalogue::transport_router::RouteView& route_view)
+{
+	using namespace std::string_literals;
+	json::Array out;
+	out.reserve(route_view.items.size() * 2);
+
+	for (const catalogue::transport_router::RouteView::Item& item : route_view.items) {
+		out.push_back(json::Builder{}.StartDict()
+			.Key("type"s).Value("Wait"s)
+			.Key("stop_name").Value(std::string(item.stop_name))
+			.Key("time"s).Value(item.wait_time)
+			.EndDict().Build().AsDict());
+		out.push_back(json::Builder{}.StartDict()
+			.Key("type"s).Value("Bus"s)
+			.Key("bus"s).Value(std::string(item.bus_name))
+			.Key("span_count"s).Value(item.span_count)
+			.Key("time"s).Value(item.bus_time)
+			.EndDict().Build().AsDict());
+	}
+	return json::Builder{}.StartDict()
+		.Key("total_time"s).Value(route_view.total_time)
+		.Key("items"s).Value(std::move(out))
+		.EndDict().Build();
+}
+
+json::Node RequestHandler::Matrix(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const
+{
+	std::vector<catalogue::StopId> from_stops, to_stops;
+	if (!FindStopIds(from, from_stops) || !FindStopIds(to, to_stops)) {
+		return json::Node();
+	}
+	std::optional<catalogue::transport_router::TransportRouter::TravelTimes> travel_times = router_.Matrix(from_stops, to_stops);
+	if (!travel_times) {
+		return json::Node();
+	}
+	json::Array out;
+	out.reserve(travel_times->size());
+	for (const auto& row : *travel_times) {
+		json::Array row_out;
+		row_out.reserve(row.size());
+		for (const std::optional<double>& time : row) {
+			row_out.push_back(time ? json::Node(*time) : json::Node());
+		}
+		out.push_back(std::move(row_out));
+	}
+	return out;
+}
+
+json::Node RequestHandler::Isochrone(std::string_view from, double max_time) const
+{
+	using namespace std::string_literals;
+	const std::optional<catalogue::StopId> from_stop = db_.FindStopId(from);
+	if (!from_stop) {
+		return json::Node();
+	}
+	std::optional<catalogue::transport_router::TransportRouter::ReachableStops> reachable_stops = router_.Reachable(*from_stop, max_time);
+	if (!reachable_stops) {
+		return json::Node();
+	}
+	json::Array out;
+	out.reserve(reachable_stops->size());
+	for (const auto& [stop_name, time] : *reachable_stops) {
+		out.push_back(json::Builder{}.StartDict()
+			.Key("stop_name"s).Value(std::string(stop_name))
+			.Key("time"s).Value(time)
+			.EndDict().Build());
+	}
+	return out;
+}
+
+json::Node RequestHandler::NearestStops(geo::Coordinates point, size_t count) const
+{
+	return StopsToJson(stops_index_.Nearest(point, count));
+}
+
+json::Node RequestHandler::StopsInRadius(geo::Coordinates point, double radius) const
+{
+	return StopsToJson(stops_index_.InRadius(point, radius));
+}
+
+json::Node RequestHandler::StopsToJson(const catalogue::StopsIndex::StopsDistances& stops)
+{
+	using namespace std::string_literals;
+	json::Array out;
+	out.reserve(stops.size());
+	for (const auto& [stop, distance] : stops) {
+		out.push_back(json::Builder{}.StartDict()
+			.Key("stop_name"s).Value(std::string(stop->name))
+			.Key("distance"s).Value(distance)
+			.EndDict().Build());
+	}
+	return out;
+}
+
+json::Node RequestHandler::Stats() const
+{
+	using namespace std::string_literals;
+	const memory::MemoryStats catalogue = db_.GetMemoryStats();
+	const memory::MemoryStats router = router_.GetMemoryStats();
+	const memory::MemoryStats map = RenderMap().GetMemoryStats();
+	return json::Builder{}.StartDict()
+		.Key("total_bytes"s).Value(SizeToJson(memory::GetTotalBytes(catalogue) + memory::GetTotalBytes(router) + memory::GetTotalBytes(map)).GetValue())
+		.Key("catalogue"s).Value(MemoryStatsToJson(catalogue).GetValue())
+		.Key("router"s).Value(MemoryStatsToJson(router).GetValue())
+		.Key("map"s).Value(MemoryStatsToJson(map).GetValue())
+		.EndDict().Build();
+}
+
+json::Node RequestHandler::MemoryStatsToJson(const memory::MemoryStats& stats)
+{
+	using namespace std::string_literals;
+	json::Array containers;
+	containers.reserve(stats.size());
+	for (const memory::ContainerStats& container : stats) {
+		containers.push_back(json::Builder{}.StartDict()
+			.Key("name"s).Value(container.name)
+			.Key("elements"s).Value(SizeToJson(container.elements).GetValue())
+			.Key("bytes"s).Value(SizeToJson(container.bytes).GetValue())
+			.EndDict().Build());
+	}
+	return json::Builder{}.StartDict()
+		.Key("total_bytes"s).Value(SizeToJson(memory::GetTotalBytes(stats)).GetValue())
+		.Key("containers"s).Value(std::move(containers))
+		.EndDict().Build();
+}
+
+json::Node RequestHandler::SizeToJson(std::uint64_t size)
+{
+	if (size <= static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+		return static_cast<int>(size);
+	}
+	return static_cast<double>(size);
+}
\ No newline at end of file
@@ -1,17 +1,23 @@
 #pragma once
+#include <cstdint>
 #include <string_view>
 #include <optional>
+#include <vector>
 
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "svg.h"
 #include "transport_router.h"
+#include "timetable_router.h"
+#include "stops_index.h"
+#include "geo.h"
 #include "json.h"
+#include "memory_stats.h"
 
 class RequestHandler {
 public:
     // MapRenderer понадобится в следующей части итогового проекта
-    RequestHandler(const catalogue::TransportCatalogue& db, const renderer::MapRenderer& renderer, const catalogue::transport_router::TransportRouter& router);
+    RequestHandler(const catalogue::TransportCatalogue& db, const renderer::MapRenderer& renderer, const catalogue::transport_router::TransportRouter& router, const catalogue::timetable_router::TimetableRouter& timetable_router, const catalogue::StopsIndex& stops_index);
 
     // Возвращает информацию о маршруте (запрос Bus)
     const catalogue::BusInfo* GetBusStat(std::string_view bus_name) const;
@@ -19,14 +25,48 @@ public:
     // Возвращает маршруты, проходящие через
     std::optional<catalogue::StopInfo> GetBusesByStop(std::string_view stop_name) const;
 
+    std::string_view GetBusName(catalogue::BusId bus) const;
+
     // Возвращает получившуюся картинку в виде svg документа
     svg::Document RenderMap() const;
 
     json::Node Route(std::string_view, std::string_view) const;
 
+    // Самый ранний приезд по расписанию при выезде не раньше departure_time
+    json::Node Route(std::string_view from, std::string_view to, double departure_time) const;
+
+    // Матрица времён в пути: массив строк по источникам, null — маршрута нет
+    json::Node Matrix(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const;
+
+    // Остановки, достижимые за max_time минут: массив словарей stop_name/time
+    json::Node Isochrone(std::string_view from, double max_time) const;
+
+    // count ближайших к point остановок: массив словарей stop_name/distance (метры)
+    json::Node NearestStops(geo::Coordinates point, size_t count) const;
+
+    // остановки не дальше radius метров от point, в том же формате
+    json::Node StopsInRadius(geo::Coordinates point, double radius) const;
+
+    // Память справочника, маршрутизатора и svg-документа карты: словарь разделов,
+    // в каждом total_bytes и массив containers со словарями name/elements/bytes
+    json::Node Stats() const;
+
+    // Неотрицательное целое в json: целые там только int, поэтому большие значения — числом с плавающей точкой
+    static json::Node SizeToJson(std::uint64_t size);
+
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
     const catalogue::TransportCatalogue& db_;
     const renderer::MapRenderer& renderer_;
     const catalogue::transport_router::TransportRouter& router_;
+    const catalogue::timetable_router::TimetableRouter& timetable_router_;
+    const catalogue::StopsIndex& stops_index_;
+
+    // названия остановок в номера справочника; false, если какой-то остановки нет
+    bool FindStopIds(const std::vector<std::string_view>& stop_names, std::vector<catalogue::StopId>& stop_ids) const;
+
+    static json::Node StopsToJson(const catalogue::StopsIndex::StopsDistances& stops);
+    static json::Node MemoryStatsToJson(const memory::MemoryStats& stats);
+    static json::Node RouteToJson(const catalogue::transport_router::BuiltRoute& built_route);
+    static json::Node RouteToJson(const catalogue::transport_router::RouteView& route_view);
 };
\ No newline at end of file
@@ -1,19 +1,56 @@
 ﻿#pragma once
 
 #include "graph.h"
+#include "memory_stats.h"
+#include "relax_kernel.h"
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
+    // Барьер для потоков, строящих таблицу Router: никто не переходит к следующей
+    // промежуточной вершине, пока все не закончили с текущей
+    class RouterBarrier {
+    public:
+        explicit RouterBarrier(size_t thread_count)
+            : thread_count_(thread_count) {
+        }
+
+        void Wait() {
+            std::unique_lock lock(mutex_);
+            const size_t generation = generation_;
+            if (++waiting_ == thread_count_) {
+                waiting_ = 0;
+                ++generation_;
+                cv_.notify_all();
+            }
+            else {
+                cv_.wait(lock, [this, generation] { return generation != generation_; });
+            }
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        const size_t thread_count_;
+        size_t waiting_ = 0;
+        size_t generation_ = 0;
+    };
+
     template <typename Weight>
     class Router {
     private:
@@ -24,9 +61,113 @@ namespace graph {
             Weight weight;
             std::optional<EdgeId> prev_edge;
         };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+        // Плотная таблица путей V x V: веса и последние рёбра путей лежат в двух
+        // непрерывных массивах по строкам. Отсутствие пути обозначается весом NO_ROUTE,
+        // отсутствие ребра (путь из вершины в саму себя) — NO_EDGE
+        class RoutesInternalData {
+        public:
+            using CompactEdgeId = std::uint32_t;
+            static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::infinity();
+            static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+
+            RoutesInternalData() = default;
+            explicit RoutesInternalData(size_t vertex_count)
+                : vertex_count_(vertex_count)
+                , weights_(vertex_count * vertex_count, NO_ROUTE)
+                , prev_edges_(vertex_count * vertex_count, NO_EDGE) {
+            }
+
+            size_t GetVertexCount() const {
+                return vertex_count_;
+            }
+
+            //расширяет таблицу до vertex_count вершин; пути между прежними вершинами сохраняются,
+            //новые вершины пока недостижимы ни из какой другой
+            void Grow(size_t vertex_count) {
+                if (vertex_count <= vertex_count_) {
+                    return;
+                }
+                std::vector<Weight> weights(vertex_count * vertex_count, NO_ROUTE);
+                std::vector<CompactEdgeId> prev_edges(vertex_count * vertex_count, NO_EDGE);
+                for (VertexId from = 0; from < vertex_count_; ++from) {
+                    std::copy_n(GetWeights(from), vertex_count_, weights.data() + from * vertex_count);
+                    std::copy_n(GetPrevEdges(from), vertex_count_, prev_edges.data() + from * vertex_count);
+                }
+                vertex_count_ = vertex_count;
+                weights_ = std::move(weights);
+                prev_edges_ = std::move(prev_edges);
+            }
+
+            std::optional<RouteInternalData> Get(VertexId from, VertexId to) const {
+                CheckVertices(from, to);
+                const size_t index = from * vertex_count_ + to;
+                if (weights_[index] == NO_ROUTE) {
+                    return std::nullopt;
+                }
+                return RouteInternalData{ weights_[index], ToEdgeId(prev_edges_[index]) };
+            }
+
+            void Set(VertexId from, VertexId to, const RouteInternalData& route) {
+                CheckVertices(from, to);
+                const size_t index = from * vertex_count_ + to;
+                weights_[index] = route.weight;
+                prev_edges_[index] = route.prev_edge ? ToCompactEdgeId(*route.prev_edge) : NO_EDGE;
+            }
+
+            //строки таблицы для горячих циклов, без проверок границ
+            Weight* GetWeights(VertexId from) {
+                return weights_.data() + from * vertex_count_;
+            }
+            const Weight* GetWeights(VertexId from) const {
+                return weights_.data() + from * vertex_count_;
+            }
+            CompactEdgeId* GetPrevEdges(VertexId from) {
+                return prev_edges_.data() + from * vertex_count_;
+            }
+            const CompactEdgeId* GetPrevEdges(VertexId from) const {
+                return prev_edges_.data() + from * vertex_count_;
+            }
+
+            memory::MemoryStats GetMemoryStats() const {
+                return { memory::Describe("weights_", weights_), memory::Describe("prev_edges_", prev_edges_) };
+            }
+
+            static std::optional<EdgeId> ToEdgeId(CompactEdgeId edge_id) {
+                if (edge_id == NO_EDGE) {
+                    return std::nullopt;
+                }
+                return edge_id;
+            }
+
+            static CompactEdgeId ToCompactEdgeId(EdgeId edge_id) {
+                if (edge_id >= NO_EDGE) {
+                    throw std::length_error("Too many edges for Router");
+                }
+                return static_cast<CompactEdgeId>(edge_id);
+            }
+
+        private:
+            void CheckVertices(VertexId from, VertexId to) const {
+                if (from >= vertex_count_ || to >= vertex_count_) {
+                    throw std::out_of_range("Vertex id is out of range");
+                }
+            }
+
+            size_t vertex_count_ = 0;
+            std::vector<Weight> weights_;
+            std::vector<CompactEdgeId> prev_edges_;
+        };
+
+        using BuildTime = std::chrono::steady_clock::duration;
 
         explicit Router(const Graph& graph);
+        // Параллельное построение: строки таблицы делятся на полосы по ROWS_PER_TILE,
+        // полосы распределяются между thread_count потоками (0 — по числу ядер).
+        // Для каждой промежуточной вершины потоки синхронизируются барьером, поэтому
+        // порядок релаксаций каждой ячейки тот же, что и в последовательной версии,
+        // и результат совпадает с ней побитово
+        explicit Router(const Graph& graph, size_t thread_count);
         explicit Router(const Graph& graph, RoutesInternalData routes_internal_data);
 
         struct RouteInfo {
@@ -36,92 +177,187 @@ namespace graph {
 
         std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+        // То же без выделения памяти: рёбра пути записываются в edges (прежнее содержимое
+        // стирается, ёмкость переиспользуется), возвращается вес пути
+        std::optional<Weight> BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
         const RoutesInternalData& GetRouterInternalData() const;
 
+        // Дописывает в таблицу вершины и рёбра, добавленные в граф после построения таблицы
+        // (или после предыдущего Update). Новый кратчайший путь состоит из старых путей и новых
+        // рёбер, стыкующихся в концах новых рёбер, поэтому достаточно релаксации через эти K
+        // вершин: O(K * V^2) вместо O(V^3) полного построения. Возвращает затраченное время
+        BuildTime Update();
+
+        // Время построения таблицы; для загруженной из готовых данных таблицы равно нулю
+        BuildTime GetBuildTime() const;
+
+        memory::MemoryStats GetMemoryStats() const;
+
     private:
+        using CompactEdgeId = typename RoutesInternalData::CompactEdgeId;
+        static constexpr Weight NO_ROUTE = RoutesInternalData::NO_ROUTE;
+        static constexpr CompactEdgeId NO_EDGE = RoutesInternalData::NO_EDGE;
+
         void InitializeRoutesInternalData(const Graph& graph) {
             const size_t vertex_count = graph.GetVertexCount();
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
-                for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                    const auto& edge = graph.GetEdge(edge_id);
-                    if (edge.weight < ZERO_WEIGHT) {
+                Weight* weights = routes_internal_data_.GetWeights(vertex);
+                CompactEdgeId* prev_edges = routes_internal_data_.GetPrevEdges(vertex);
+                weights[vertex] = ZERO_WEIGHT;
+                graph.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, const Weight& edge_weight) {
+                    if (edge_weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];  //путь от VertexId vertex до VertedId edge.to
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) { //запоминаем пути с минимальнаыми весами
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                    if (edge_weight < weights[edge_to]) { //запоминаем пути с минимальнаыми весами
+                        weights[edge_to] = edge_weight;
+                        prev_edges[edge_to] = RoutesInternalData::ToCompactEdgeId(edge_id);
                     }
-                }
+                });
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) { //если пути нет, то мы его создаем, а если есть, то сокращаем
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
-            }
+        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
+            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through, 0, vertex_count);
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
-                    }
+        //релаксирует только строки [from_begin, from_end); строка и столбец vertex_through
+        //при этом не меняются, поэтому разные полосы можно обрабатывать одновременно
+        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through,
+            VertexId from_begin, VertexId from_end) {
+            const Weight* weights_through = routes_internal_data_.GetWeights(vertex_through);
+            const CompactEdgeId* prev_edges_through = routes_internal_data_.GetPrevEdges(vertex_through);
+            for (VertexId vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+                Weight* weights = routes_internal_data_.GetWeights(vertex_from);
+                CompactEdgeId* prev_edges = routes_internal_data_.GetPrevEdges(vertex_from);
+                const Weight weight_from = weights[vertex_through];
+                if (weight_from == NO_ROUTE) {
+                    continue;
+                }
+                //если пути через vertex_through нет, то его вес NO_ROUTE и кандидат ничего не меняет
+                if constexpr (std::is_same_v<Weight, double>) {
+                    RelaxRow(weight_from, prev_edges[vertex_through], weights_through, prev_edges_through,
+                        weights, prev_edges, vertex_count, NO_EDGE);
+                }
+                else {
+                    RelaxRowScalar(weight_from, prev_edges[vertex_through], weights_through, prev_edges_through,
+                        weights, prev_edges, vertex_count, NO_EDGE);
                 }
             }
         }
 
+        static_assert(std::numeric_limits<Weight>::has_infinity, "Router needs a weight type with infinity");
         static constexpr Weight ZERO_WEIGHT{};
+        static constexpr size_t ROWS_PER_TILE = 64;
         const Graph& graph_;
         RoutesInternalData routes_internal_data_;
+        size_t edge_count_ = 0; //рёбра графа, уже учтённые в таблице
+        BuildTime build_time_{};
     };
 
     template <typename Weight>
     Router<Weight>::Router(const Graph& graph)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+        , routes_internal_data_(graph.GetVertexCount())
+        , edge_count_(graph.GetEdgeCount())
     {
+        const auto start = std::chrono::steady_clock::now();
         InitializeRoutesInternalData(graph); //инициализируем все возможные пути
 
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
             RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through); //сокращаем ненужные грани
         }
+        build_time_ = std::chrono::steady_clock::now() - start;
+    }
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, size_t thread_count)
+        : graph_(graph)
+        , routes_internal_data_(graph.GetVertexCount())
+        , edge_count_(graph.GetEdgeCount())
+    {
+        const auto start = std::chrono::steady_clock::now();
+        InitializeRoutesInternalData(graph);
+
+        const size_t vertex_count = graph.GetVertexCount();
+        const size_t tile_count = (vertex_count + ROWS_PER_TILE - 1) / ROWS_PER_TILE;
+        if (thread_count == 0) {
+            thread_count = std::thread::hardware_concurrency();
+        }
+        thread_count = std::max<size_t>(1, std::min(thread_count, tile_count));
+
+        RouterBarrier barrier(thread_count);
+        auto relax_tiles = [this, vertex_count, tile_count, thread_count, &barrier](size_t thread_index) {
+            for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                //полосы раздаются потокам по кругу, чтобы неравномерно заполненные строки не копились у одного потока
+                for (size_t tile = thread_index; tile < tile_count; tile += thread_count) {
+                    const VertexId from_begin = tile * ROWS_PER_TILE;
+                    const VertexId from_end = std::min(vertex_count, from_begin + ROWS_PER_TILE);
+                    RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through, from_begin, from_end);
+                }
+                barrier.Wait();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+            threads.emplace_back(relax_tiles, thread_index);
+        }
+        relax_tiles(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        build_time_ = std::chrono::steady_clock::now() - start;
     }
 
     template<typename Weight>
     Router<Weight>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
         : graph_(graph)
-        , routes_internal_data_(std::move(routes_internal_data)) {
+        , routes_internal_data_(std::move(routes_internal_data))
+        , edge_count_(graph.GetEdgeCount()) {
+        if (routes_internal_data_.GetVertexCount() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Routes internal data doesn't match the graph");
+        }
     }
 
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
         VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
+        std::vector<EdgeId> edges;
+        const std::optional<Weight> weight = BuildRoute(from, to, edges);
+        if (!weight) {
+            return std::nullopt;
+        }
+        return RouteInfo{ *weight, std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::optional<Weight> Router<Weight>::BuildRoute(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+        edges.clear();
+        const auto route_internal_data = routes_internal_data_.Get(from, to);
         if (!route_internal_data) { //если пути нет, то говорим, что построить маршрут невозможно
             return std::nullopt;
         }
-        
-        const Weight weight = route_internal_data->weight;
-        std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+
+        //первый проход считает длину пути, второй заполняет рёбра с конца, без разворота
+        const CompactEdgeId* prev_edges = routes_internal_data_.GetPrevEdges(from);
+        size_t edge_count = 0;
+        for (CompactEdgeId edge_id = prev_edges[to];
+            edge_id != NO_EDGE;
+            edge_id = prev_edges[graph_.GetEdge(edge_id).from])
         {
-            edges.push_back(*edge_id);
+            ++edge_count;
         }
-        std::reverse(edges.begin(), edges.end());
-
-        return RouteInfo{ weight, std::move(edges) };
+        edges.resize(edge_count);
+        for (CompactEdgeId edge_id = prev_edges[to];
+            edge_id != NO_EDGE;
+            edge_id = prev_edges[graph_.GetEdge(edge_id).from])
+        {
+            edges[--edge_count] = edge_id;
+        }
+        return route_internal_data->weight;
     }
 
     template<typename Weight>
@@ -129,4 +365,50 @@ namespace graph {
         return routes_internal_data_;
     }
 
+    template<typename Weight>
+    typename Router<Weight>::BuildTime Router<Weight>::Update() {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t old_vertex_count = routes_internal_data_.GetVertexCount();
+        routes_internal_data_.Grow(vertex_count);
+        for (VertexId vertex = old_vertex_count; vertex < vertex_count; ++vertex) {
+            routes_internal_data_.GetWeights(vertex)[vertex] = ZERO_WEIGHT;
+        }
+
+        std::vector<VertexId> vertices_through;
+        for (EdgeId edge_id = edge_count_; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            Weight& weight = routes_internal_data_.GetWeights(edge.from)[edge.to];
+            if (edge.weight < weight) {
+                weight = edge.weight;
+                routes_internal_data_.GetPrevEdges(edge.from)[edge.to] = RoutesInternalData::ToCompactEdgeId(edge_id);
+            }
+            vertices_through.push_back(edge.from);
+            vertices_through.push_back(edge.to);
+        }
+        edge_count_ = graph_.GetEdgeCount();
+
+        std::sort(vertices_through.begin(), vertices_through.end());
+        vertices_through.erase(std::unique(vertices_through.begin(), vertices_through.end()), vertices_through.end());
+        for (const VertexId vertex_through : vertices_through) {
+            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        }
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    template<typename Weight>
+    typename Router<Weight>::BuildTime Router<Weight>::GetBuildTime() const {
+        return build_time_;
+    }
+
+    template<typename Weight>
+    memory::MemoryStats Router<Weight>::GetMemoryStats() const {
+        memory::MemoryStats stats;
+        memory::Append(stats, "routes_internal_data_.", routes_internal_data_.GetMemoryStats());
+        return stats;
+    }
+
 }  // namespace graph
\ No newline at end of file
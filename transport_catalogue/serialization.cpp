@@ -8,6 +8,7 @@
 #include <variant>
 #include <vector>
 #include <map>
+#include <stdexcept>
 
 namespace catalogue {
 
@@ -30,7 +31,7 @@ namespace catalogue {
 		return color_message;
 	}
 
-	void Serialization::SerializeCatalogue(const catalogue::TransportCatalogue& database, const renderer::MapRenderer& map_renderer, const catalogue::transport_router::TransportRouter& transport_router) const
+	transport_catalogue::Data MakeDataMessage(const catalogue::TransportCatalogue& database, const renderer::MapRenderer& map_renderer, const catalogue::transport_router::TransportRouter& transport_router)
 	{
 		transport_catalogue::Data data_to_store;
 		transport_catalogue::TransportCatalogue& catalogue_message = *data_to_store.mutable_transport_catalogue();
@@ -38,7 +39,10 @@ namespace catalogue {
 		{
 			transport_catalogue::Stop stop_message;
 			for (const catalogue::Stop& stop : database.GetStops()) {
-				stop_message.set_name(stop.name);
+				if (database.IsStopRemoved(stop.id)) { //     
+					continue;
+				}
+				stop_message.set_name(static_cast<std::string>(stop.name));
 				(*stop_message.mutable_coordinates()).set_lat(stop.coordinates.lat);
 				(*stop_message.mutable_coordinates()).set_lng(stop.coordinates.lng);
 				*catalogue_message.add_stops() = stop_message;
@@ -47,24 +51,37 @@ namespace catalogue {
 		// Distance
 		{
 			transport_catalogue::Distance distance_message;
-			for (const auto& [from_to, distance] : database.GetStopsDistances()) {
-				distance_message.set_from(from_to.first->name);
-				distance_message.set_to(from_to.second->name);
-				distance_message.set_distance(distance);
-				*catalogue_message.add_distances() = distance_message;
+			const std::vector<RoadDistances>& stops_distances = database.GetStopsDistances();
+			for (StopId from = 0; from < stops_distances.size(); ++from) {
+				for (const RoadDistance& distance : stops_distances[from]) {
+					if (distance.forward == RoadDistance::NO_DISTANCE) { //    
+						continue;
+					}
+					distance_message.set_from(static_cast<std::string>(database.GetStop(from).name));
+					distance_message.set_to(static_cast<std::string>(database.GetStop(distance.stop).name));
+					distance_message.set_distance(distance.forward);
+					*catalogue_message.add_distances() = distance_message;
+				}
 			}
 		}
 		// buses
 		{
 			transport_catalogue::Bus message_bus;
 			for (const Bus& bus : database.GetBuses()) {
-				message_bus.set_name(bus.name);
+				if (database.IsBusRemoved(bus.id)) {
+					continue;
+				}
+				message_bus.set_name(static_cast<std::string>(bus.name));
 				message_bus.set_is_roundtrip(bus.is_roundtrip);
 				for (const Stop* stop : bus.stops) {
-					*message_bus.add_stops() = stop->name;
+					*message_bus.add_stops() = static_cast<std::string>(stop->name);
+				}
+				for (const double departure : bus.departures) {
+					message_bus.add_departures(departure);
 				}
 				*catalogue_message.add_buses() = message_bus;
 				message_bus.clear_stops();
+				message_bus.clear_departures();
 			}
 		}
 
@@ -95,16 +112,29 @@ namespace catalogue {
 		transport_catalogue::TransportRouterData& transport_router_data_message = *data_to_store.mutable_transport_router_data();
 		const catalogue::transport_router::TransportRouter::TransportRouterData& transport_router_data = transport_router.GetTransportRouterData();
 		{
-			//bus_wait_time
-			transport_router_data_message.set_bus_wait_time(transport_router_data.bus_wait_time);
+			//routing_settings
+			transport_router_data_message.set_bus_wait_time(transport_router_data.settings.bus_wait_time);
+			transport_router_data_message.set_bus_velocity(transport_router_data.settings.bus_velocity);
+			transport_router_data_message.set_router_type(static_cast<transport_catalogue::RouterType>(transport_router_data.settings.router_type));
+			transport_router_data_message.set_route_cache_capacity(transport_router_data.settings.route_cache_capacity);
+			transport_router_data_message.set_graph_model(static_cast<transport_catalogue::GraphModel>(transport_router_data.settings.graph_model));
 			//stop_vertex_id
-			for (const auto [stop, vertex_id] : transport_router_data.stop_vertex_id) {
+			//       ,   
+			for (StopId stop_id = 0; stop_id < transport_router_data.stop_vertex_id.size(); ++stop_id) {
+				const graph::VertexId vertex_id = transport_router_data.stop_vertex_id[stop_id];
+				if (vertex_id == catalogue::transport_router::TransportRouter::NO_VERTEX || database.IsStopRemoved(stop_id)) {
+					continue;
+				}
 				transport_catalogue::StopVertexId& elem = *transport_router_data_message.add_stop_vertex_id();
-				elem.set_stop(static_cast<std::string>(stop));
+				elem.set_stop(static_cast<std::string>(database.GetStop(stop_id).name));
 				elem.set_vertex_id(vertex_id);
 			}
 			//edges_extra_info
 			for (const auto [bus_name, span_count] : transport_router_data.edges_extra_info) {
+				//  :     ,     
+				if (!database.FindBusId(bus_name)) {
+					throw std::logic_error("Unable to serialize router: bus " + std::string(bus_name) + " was removed, call TransportRouter::Rebuild first");
+				}
 				transport_catalogue::EdgeExtraInfo& elem = *transport_router_data_message.add_edges_extra_info();
 				elem.set_bus_name(static_cast<std::string>(bus_name));
 				elem.set_span_count(span_count);
@@ -121,22 +151,52 @@ namespace catalogue {
 			}
 			//  Router
 			transport_catalogue::Router& router = *transport_router_data_message.mutable_router();
-			for (const auto& inner_vector : transport_router_data.router.GetRouterInternalData()) {
-				transport_catalogue::VectorRouteInternalData& inner_vector_message = *router.add_vector();
-				for (const auto& elem : inner_vector) {
-					transport_catalogue::OptionalRouteInternalData& elem_message = *inner_vector_message.add_optional();
-					if (elem.has_value()) {
-						elem_message.mutable_route_internal_data()->set_weight(elem->weight);
-						if (elem->prev_edge.has_value()) {
-							elem_message.mutable_route_internal_data()->mutable_prev_edge()->set_id(elem->prev_edge.value());
+			if (transport_router_data.router != nullptr) {
+				const auto& routes_internal_data = transport_router_data.router->GetRouterInternalData();
+				const size_t vertex_count = routes_internal_data.GetVertexCount();
+				for (graph::VertexId from = 0; from < vertex_count; ++from) {
+					transport_catalogue::VectorRouteInternalData& inner_vector_message = *router.add_vector();
+					for (graph::VertexId to = 0; to < vertex_count; ++to) {
+						transport_catalogue::OptionalRouteInternalData& elem_message = *inner_vector_message.add_optional();
+						if (const auto elem = routes_internal_data.Get(from, to)) {
+							elem_message.mutable_route_internal_data()->set_weight(elem->weight);
+							if (elem->prev_edge.has_value()) {
+								elem_message.mutable_route_internal_data()->mutable_prev_edge()->set_id(elem->prev_edge.value());
+							}
 						}
 					}
 				}
 			}
+			//  ContractionHierarchy
+			if (transport_router_data.contraction_hierarchy != nullptr) {
+				transport_catalogue::ContractionHierarchy& contraction_hierarchy = *transport_router_data_message.mutable_contraction_hierarchy();
+				const auto& hierarchy_data = transport_router_data.contraction_hierarchy->GetData();
+				for (const size_t rank : hierarchy_data.ranks) {
+					contraction_hierarchy.add_ranks(rank);
+				}
+				for (const auto& arc : hierarchy_data.arcs) {
+					transport_catalogue::ContractionHierarchyArc& elem = *contraction_hierarchy.add_arcs();
+					elem.set_from(arc.from);
+					elem.set_to(arc.to);
+					elem.set_weight(arc.weight);
+					if (arc.edge_id.has_value()) {
+						elem.mutable_edge_id()->set_id(arc.edge_id.value());
+					}
+					else {
+						elem.set_first(arc.first);
+						elem.set_second(arc.second);
+					}
+				}
+			}
 		}
 
+		return data_to_store;
+	}
+
+	void Serialization::SerializeCatalogue(const catalogue::TransportCatalogue& database, const renderer::MapRenderer& map_renderer, const catalogue::transport_router::TransportRouter& transport_router) const
+	{
 		std::ofstream out_file(filename_, std::ios::binary);
-		data_to_store.SerializeToOstream(&out_file);
+		MakeDataMessage(database, map_renderer, transport_router).SerializeToOstream(&out_file);
 	}
 
 	svg::Color GetSvgColor(const transport_catalogue::Color& color_message) {
@@ -158,43 +218,53 @@ namespace catalogue {
 		return color;
 	}
 
-	std::optional<Serialization::SerializationOut> Serialization::DeserializeCatalogue() const
+	Serialization::SerializationOut ParseDataMessage(const transport_catalogue::Data& data_to_parse)
 	{
-		std::ifstream in_file(filename_, std::ios::binary);
-		transport_catalogue::Data data_to_parse;
-		if (!data_to_parse.ParseFromIstream(&in_file)) {
-			return std::nullopt;
-		}
 		const transport_catalogue::TransportCatalogue& catalogue_message = data_to_parse.transport_catalogue();
 		catalogue::TransportCatalogue database;
 		// Stop
 		{
-			catalogue::Stop stop;
+			std::vector<catalogue::Stop> stops;
+			stops.reserve(catalogue_message.stops_size());
 			for (const transport_catalogue::Stop& stop_message : catalogue_message.stops()) {
+				catalogue::Stop& stop = stops.emplace_back();
 				stop.name = stop_message.name();
 				stop.coordinates.lat = stop_message.coordinates().lat();
 				stop.coordinates.lng = stop_message.coordinates().lng();
-				database.AddStop(stop);
 			}
+			database.AddStops(std::move(stops));
 		}
 		// Distance
 		{
+			std::vector<catalogue::StopsDistance> distances;
+			distances.reserve(catalogue_message.distances_size());
 			for (const transport_catalogue::Distance& distance_message : catalogue_message.distances()) {
-				database.AddDistance(distance_message.from(), distance_message.to(), distance_message.distance());
+				distances.push_back({ distance_message.from(), distance_message.to(), distance_message.distance() });
 			}
+			database.AddDistances(distances);
 		}
 		// Bus
 		{
-			catalogue::Bus bus;
+			//   ,  ,     
+			std::vector<const Stop*> buses_stops;
+			std::vector<size_t> buses_stops_begin;
+			std::vector<catalogue::Bus> buses;
+			buses.reserve(catalogue_message.buses_size());
 			for (const transport_catalogue::Bus& bus_message : catalogue_message.buses()) {
+				catalogue::Bus& bus = buses.emplace_back();
 				bus.name = bus_message.name();
 				bus.is_roundtrip = bus_message.is_roundtrip();
+				buses_stops_begin.push_back(buses_stops.size());
 				for (const std::string_view& stop_name : bus_message.stops()) {
-					bus.stops.push_back(database.GetStopByName(stop_name));
+					buses_stops.push_back(database.GetStopByName(stop_name));
 				}
-				database.AddBus(bus);
-				bus.stops.clear();
+				bus.departures.assign(bus_message.departures().begin(), bus_message.departures().end());
 			}
+			buses_stops_begin.push_back(buses_stops.size());
+			for (size_t i = 0; i < buses.size(); ++i) {
+				buses[i].stops = arena::Span<const Stop*>(buses_stops.data() + buses_stops_begin[i], buses_stops_begin[i + 1] - buses_stops_begin[i]);
+			}
+			database.AddBuses(std::move(buses));
 		}
 		// Settings
 		const transport_catalogue::Settings& settings_message = data_to_parse.settings();
@@ -219,8 +289,13 @@ namespace catalogue {
 		}
 		// transport_router_data
 		const transport_catalogue::TransportRouterData& transport_router_data = data_to_parse.transport_router_data();
-		// bus_wait_time
-		double bus_wait_time = transport_router_data.bus_wait_time();
+		// routing_settings
+		catalogue::transport_router::RoutingSettings routing_settings;
+		routing_settings.bus_wait_time = transport_router_data.bus_wait_time();
+		routing_settings.bus_velocity = transport_router_data.bus_velocity();
+		routing_settings.router_type = static_cast<catalogue::transport_router::RouterType>(transport_router_data.router_type());
+		routing_settings.route_cache_capacity = transport_router_data.route_cache_capacity();
+		routing_settings.graph_model = static_cast<catalogue::transport_router::GraphModel>(transport_router_data.graph_model());
 
 		const transport_catalogue::Graph& graph_message = transport_router_data.graph();
 		// graph
@@ -234,34 +309,64 @@ namespace catalogue {
 			edges_extra_info.push_back({ database.GetBusByName(edge_extra_info_message.bus_name())->name, edge_extra_info_message.span_count() });
 		}
 		// StopVertexId  VertexIdStop
-		typename catalogue::transport_router::TransportRouter::StopVertexId stop_vertex_id;
-		typename catalogue::transport_router::TransportRouter::VertexIdStop vertex_id_stop;
+		typename catalogue::transport_router::TransportRouter::StopVertexId stop_vertex_id(database.GetStopsSize(), catalogue::transport_router::TransportRouter::NO_VERTEX);
+		typename catalogue::transport_router::TransportRouter::VertexIdStop vertex_id_stop(graph_message.vertex_count(), nullptr);
 		for (const auto& stop_id : transport_router_data.stop_vertex_id()) {
-			std::string_view stop_name = database.GetStopByName(stop_id.stop())->name;
-			stop_vertex_id[stop_name] = stop_id.vertex_id();
-			vertex_id_stop[stop_id.vertex_id()] = stop_name;
+			const Stop* stop = database.GetStopByName(stop_id.stop());
+			stop_vertex_id[stop->id] = stop_id.vertex_id();
+			vertex_id_stop.at(stop_id.vertex_id()) = stop;
 		}
 		// Router
-		typename graph::Router<double>::RoutesInternalData routes_internal_data;
-		std::vector<std::optional<graph::Router<double>::RouteInternalData>> inner_vector;
+		const auto& rows_message = transport_router_data.router().vector();
+		typename graph::Router<double>::RoutesInternalData routes_internal_data(rows_message.empty() ? 0 : graph_message.vertex_count());
 		graph::Router<double>::RouteInternalData internal_data;
-		for (const auto& inner_vector_message : transport_router_data.router().vector()) {
-			for (const auto& optional_data : inner_vector_message.optional()) {
+		for (graph::VertexId from = 0; from < static_cast<graph::VertexId>(rows_message.size()); ++from) {
+			const auto& row_message = rows_message[from].optional();
+			for (graph::VertexId to = 0; to < static_cast<graph::VertexId>(row_message.size()); ++to) {
+				const auto& optional_data = row_message[to];
 				if (optional_data.has_route_internal_data()) {
 					internal_data.weight = optional_data.route_internal_data().weight();
 					if (optional_data.route_internal_data().has_prev_edge()) {
 						internal_data.prev_edge.emplace(optional_data.route_internal_data().prev_edge().id());
 					}
-					inner_vector.push_back(internal_data);
+					routes_internal_data.Set(from, to, internal_data);
 					internal_data.prev_edge.reset();
 				}
+			}
+		}
+		// ContractionHierarchy
+		typename graph::ContractionHierarchy<double>::Data contraction_hierarchy;
+		{
+			const transport_catalogue::ContractionHierarchy& contraction_hierarchy_message = transport_router_data.contraction_hierarchy();
+			contraction_hierarchy.ranks.assign(contraction_hierarchy_message.ranks().begin(), contraction_hierarchy_message.ranks().end());
+			for (const auto& arc_message : contraction_hierarchy_message.arcs()) {
+				graph::ContractionHierarchy<double>::Arc arc{ arc_message.from(), arc_message.to(), arc_message.weight(), std::nullopt };
+				if (arc_message.has_edge_id()) {
+					arc.edge_id = arc_message.edge_id().id();
+				}
 				else {
-					inner_vector.push_back(std::nullopt);
+					arc.first = arc_message.first();
+					arc.second = arc_message.second();
 				}
+				contraction_hierarchy.arcs.push_back(arc);
 			}
-			routes_internal_data.push_back(inner_vector);;
-			inner_vector.clear();
 		}
-		return SerializationOut{ std::move(database), settings, {std::move(graph), std::move(routes_internal_data), std::move(stop_vertex_id), std::move(vertex_id_stop), std::move(edges_extra_info), bus_wait_time} };
+		return Serialization::SerializationOut{ std::move(database), settings, {std::move(graph), std::move(routes_internal_data), std::move(contraction_hierarchy), std::move(stop_vertex_id), std::move(vertex_id_stop), std::move(edges_extra_info), routing_settings} };
+	}
+
+	std::optional<Serialization::SerializationOut> Serialization::DeserializeCatalogue() const
+	{
+		std::ifstream in_file(filename_, std::ios::binary);
+		transport_catalogue::Data data_to_parse;
+		if (!data_to_parse.ParseFromIstream(&in_file)) {
+			return std::nullopt;
+		}
+		return ParseDataMessage(data_to_parse);
+	}
+
+	Serialization::SerializationOut Serialization::Copy(const catalogue::TransportCatalogue& database, const renderer::MapRenderer& map_renderer, const catalogue::transport_router::TransportRouter& transport_router)
+	{
+		//  ,   ,   :         
+		return ParseDataMessage(MakeDataMessage(database, map_renderer, transport_router));
 	}
 }
\ No newline at end of file
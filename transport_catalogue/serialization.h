@@ -1,3 +1,4 @@
+#pragma once
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
@@ -13,10 +14,11 @@ namespace catalogue {
 		struct RouterSettings {
 			catalogue::transport_router::TransportRouter::Graph graph;
 			graph::Router<double>::RoutesInternalData routes_internal_data;
+			graph::ContractionHierarchy<double>::Data contraction_hierarchy;
 			catalogue::transport_router::TransportRouter::StopVertexId stop_vertex_id;
 			catalogue::transport_router::TransportRouter::VertexIdStop vertex_id_stop;
 			catalogue::transport_router::TransportRouter::EdgesExtraInfo edges_extra_info;
-			double bus_wait_time = 0.0;
+			catalogue::transport_router::RoutingSettings routing_settings;
 		};
 
 		struct SerializationOut {
@@ -33,6 +35,9 @@ namespace catalogue {
 
 		std::optional<SerializationOut> DeserializeCatalogue() const;
 
+		//  ,         
+		static SerializationOut Copy(const catalogue::TransportCatalogue& database, const renderer::MapRenderer& mr, const catalogue::transport_router::TransportRouter&);
+
 	private:
 		const std::filesystem::path filename_;
 	};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rcu {
+
+    // Публикация неизменяемых версий объекта (read-copy-update).
+    // Читатель получает текущую версию атомарной загрузкой указателя и объявляет её в своём слоте
+    // (hazard pointer); блокировок на чтении нет, и версия не меняется, пока Reader жив.
+    // Писатель строит следующую версию целиком и подменяет указатель одной атомарной записью,
+    // поэтому наполовину обновлённую версию увидеть нельзя. Старая версия удаляется, когда
+    // её больше не объявляет ни один читатель: при следующей публикации или вместе с Publisher.
+    // Слоты читателей образуют список, который только растёт: Reader занимает свободный слот,
+    // а если свободных нет — добавляет новый, так что число одновременных Reader не ограничено
+    template <typename T>
+    class SnapshotPublisher {
+        struct Version {
+            std::uint64_t number = 0;
+            std::unique_ptr<const T> value;
+        };
+
+        // занят (busy) с начала Read до разрушения Reader; version — объявленная версия.
+        // Слоты живут до разрушения Publisher, next после вставки в список не меняется
+        struct Slot {
+            std::atomic<Version*> version{ nullptr };
+            std::atomic<bool> busy{ false };
+            Slot* next = nullptr;
+        };
+
+    public:
+        class Reader {
+        public:
+            Reader(Reader&& other) noexcept
+                : publisher_(std::exchange(other.publisher_, nullptr))
+                , slot_(other.slot_)
+                , version_(other.version_) {
+            }
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+            Reader& operator=(Reader&&) = delete;
+
+            ~Reader() {
+                if (publisher_ != nullptr) {
+                    publisher_->ReleaseSlot(slot_);
+                }
+            }
+
+            const T& operator*() const {
+                return *version_->value;
+            }
+            const T* operator->() const {
+                return version_->value.get();
+            }
+            std::uint64_t GetVersion() const {
+                return version_->number;
+            }
+
+        private:
+            friend class SnapshotPublisher;
+
+            Reader(const SnapshotPublisher* publisher, Slot* slot, const Version* version)
+                : publisher_(publisher)
+                , slot_(slot)
+                , version_(version) {
+            }
+
+            const SnapshotPublisher* publisher_;
+            Slot* slot_;
+            const Version* version_;
+        };
+
+        explicit SnapshotPublisher(std::unique_ptr<const T> initial)
+            : current_(new Version{ 1, std::move(initial) }) {
+        }
+
+        SnapshotPublisher(const SnapshotPublisher&) = delete;
+        SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+        // к моменту разрушения живых Reader быть не должно
+        ~SnapshotPublisher() {
+            delete current_.load();
+            for (Slot* slot = slots_.load(); slot != nullptr;) {
+                delete std::exchange(slot, slot->next);
+            }
+        }
+
+        // никогда не ждёт ни писателя, ни других читателей
+        Reader Read() const {
+            Slot* slot = AcquireSlot();
+            Version* version = current_.load();
+            for (;;) {
+                slot->version.store(version);
+                // если указатель не сменился после объявления, писатель эту версию уже не удалит
+                Version* again = current_.load();
+                if (again == version) {
+                    break;
+                }
+                version = again;
+            }
+            return Reader(this, slot, version);
+        }
+
+        // публикует next как новую текущую версию и возвращает её номер
+        std::uint64_t Publish(std::unique_ptr<const T> next) {
+            std::lock_guard lock(writer_mutex_);
+            Version* previous = current_.load();
+            const std::uint64_t number = previous->number + 1;
+            current_.store(new Version{ number, std::move(next) });
+            retired_.emplace_back(previous);
+            Reclaim();
+            return number;
+        }
+
+        std::uint64_t GetVersion() const {
+            return current_.load()->number;
+        }
+
+        // сколько старых версий ещё удерживают читатели
+        size_t GetRetiredCount() const {
+            std::lock_guard lock(writer_mutex_);
+            return retired_.size();
+        }
+
+    private:
+        Slot* AcquireSlot() const {
+            for (Slot* slot = slots_.load(); slot != nullptr; slot = slot->next) {
+                if (!slot->busy.load(std::memory_order_relaxed) && !slot->busy.exchange(true)) {
+                    return slot;
+                }
+            }
+            // свободных нет: новый слот, уже занятый, вставляется в голову списка без блокировки
+            Slot* slot = new Slot;
+            slot->busy.store(true, std::memory_order_relaxed);
+            Slot* head = slots_.load();
+            do {
+                slot->next = head;
+            } while (!slots_.compare_exchange_weak(head, slot));
+            return slot;
+        }
+
+        void ReleaseSlot(Slot* slot) const {
+            slot->version.store(nullptr);
+            slot->busy.store(false);
+        }
+
+        void Reclaim() {
+            std::vector<std::unique_ptr<Version>> still_read;
+            for (std::unique_ptr<Version>& version : retired_) {
+                bool is_read = false;
+                for (const Slot* slot = slots_.load(); slot != nullptr; slot = slot->next) {
+                    if (slot->version.load() == version.get()) {
+                        is_read = true;
+                        break;
+                    }
+                }
+                if (is_read) {
+                    still_read.push_back(std::move(version));
+                }
+            }
+            retired_ = std::move(still_read);
+        }
+
+        std::atomic<Version*> current_;
+        mutable std::atomic<Slot*> slots_{ nullptr }; //голова списка слотов
+
+        mutable std::mutex writer_mutex_;
+        std::vector<std::unique_ptr<Version>> retired_;
+    };
+
+}
@@ -0,0 +1,176 @@
+#define _USE_MATH_DEFINES
+#include "stops_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace catalogue {
+
+	namespace {
+		double SquaredDistance(const std::array<double, 3>& lhs, const std::array<double, 3>& rhs) {
+			const double dx = lhs[0] - rhs[0];
+			const double dy = lhs[1] - rhs[1];
+			const double dz = lhs[2] - rhs[2];
+			return dx * dx + dy * dy + dz * dz;
+		}
+	}
+
+	StopsIndex::StopsIndex(const TransportCatalogue& catalogue)
+	{
+		nodes_.reserve(catalogue.GetStops().size());
+		for (const Stop& stop : catalogue.GetStops()) {
+			if (!catalogue.IsStopRemoved(stop.id)) {
+				nodes_.push_back({ ToPoint(stop.coordinates), &stop });
+			}
+		}
+		Build(0, nodes_.size());
+	}
+
+	StopsIndex::Point StopsIndex::ToPoint(geo::Coordinates coordinates)
+	{
+		const double dr = M_PI / 180.0;
+		const double lat = coordinates.lat * dr;
+		const double lng = coordinates.lng * dr;
+		return { std::cos(lat) * std::cos(lng), std::cos(lat) * std::sin(lng), std::sin(lat) };
+	}
+
+	double StopsIndex::ChordToDistance(double squared_chord)
+	{
+		//в отличие от формулы через acos, точна и для близких точек
+		return 2.0 * geo::EARTH_RADIUS * std::asin(std::min(1.0, std::sqrt(squared_chord) / 2.0));
+	}
+
+	void StopsIndex::SortByDistance(StopsDistances& stops)
+	{
+		std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
+			return std::tie(lhs.second, lhs.first->name) < std::tie(rhs.second, rhs.first->name);
+		});
+	}
+
+	void StopsIndex::Build(size_t begin, size_t end)
+	{
+		if (end - begin < 2) {
+			return;
+		}
+		//делим по оси с наибольшим разбросом: остановки одного города занимают тонкий слой сферы
+		Point min = nodes_[begin].point, max = nodes_[begin].point;
+		for (size_t i = begin + 1; i < end; ++i) {
+			for (size_t axis = 0; axis < 3; ++axis) {
+				min[axis] = std::min(min[axis], nodes_[i].point[axis]);
+				max[axis] = std::max(max[axis], nodes_[i].point[axis]);
+			}
+		}
+		std::uint8_t axis = 0;
+		for (std::uint8_t candidate = 1; candidate < 3; ++candidate) {
+			if (max[candidate] - min[candidate] > max[axis] - min[axis]) {
+				axis = candidate;
+			}
+		}
+		const size_t mid = begin + (end - begin) / 2;
+		std::nth_element(nodes_.begin() + begin, nodes_.begin() + mid, nodes_.begin() + end, [axis](const Node& lhs, const Node& rhs) {
+			return lhs.point[axis] < rhs.point[axis];
+		});
+		nodes_[mid].axis = axis;
+		Build(begin, mid);
+		Build(mid + 1, end);
+	}
+
+	StopsIndex::StopsDistances StopsIndex::Nearest(geo::Coordinates point, size_t count) const
+	{
+		StopsDistances stops;
+		if (count == 0 || nodes_.empty()) {
+			return stops;
+		}
+		//куча с наибольшим из найденных расстояний на вершине
+		std::vector<Candidate> heap;
+		heap.reserve(std::min(count, nodes_.size()) + 1);
+		FindNearest(0, nodes_.size(), ToPoint(point), count, heap);
+		stops.reserve(heap.size());
+		for (const auto& [squared_chord, node] : heap) {
+			stops.emplace_back(nodes_[node].stop, ChordToDistance(squared_chord));
+		}
+		SortByDistance(stops);
+		return stops;
+	}
+
+	StopsIndex::StopsDistances StopsIndex::InRadius(geo::Coordinates point, double radius) const
+	{
+		StopsDistances stops;
+		if (radius < 0.0 || nodes_.empty()) {
+			return stops;
+		}
+		//хорда, стягивающая дугу radius, с запасом на погрешность; точная проверка — ниже
+		const double half_angle = std::min(radius / (2.0 * geo::EARTH_RADIUS), M_PI / 2.0);
+		const double chord = 2.0 * std::sin(half_angle);
+		std::vector<size_t> found;
+		FindInRadius(0, nodes_.size(), ToPoint(point), chord * chord * (1.0 + 1e-9) + 1e-18, found);
+		const Point center = ToPoint(point);
+		for (const size_t node : found) {
+			const double distance = ChordToDistance(SquaredDistance(nodes_[node].point, center));
+			if (distance <= radius) {
+				stops.emplace_back(nodes_[node].stop, distance);
+			}
+		}
+		SortByDistance(stops);
+		return stops;
+	}
+
+	size_t StopsIndex::GetStopCount() const
+	{
+		return nodes_.size();
+	}
+
+	bool StopsIndex::IsCloser(const Candidate& lhs, const Candidate& rhs) const
+	{
+		return std::tie(lhs.first, nodes_[lhs.second].stop->name) < std::tie(rhs.first, nodes_[rhs.second].stop->name);
+	}
+
+	void StopsIndex::FindNearest(size_t begin, size_t end, const Point& point, size_t count, std::vector<Candidate>& heap) const
+	{
+		if (begin >= end) {
+			return;
+		}
+		const size_t mid = begin + (end - begin) / 2;
+		const Node& node = nodes_[mid];
+		const Candidate candidate{ SquaredDistance(node.point, point), mid };
+		//при равном расстоянии остаётся остановка с меньшим названием, как и в ответе
+		const auto is_closer = [this](const Candidate& lhs, const Candidate& rhs) { return IsCloser(lhs, rhs); };
+		if (heap.size() < count) {
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end(), is_closer);
+		}
+		else if (IsCloser(candidate, heap.front())) {
+			std::pop_heap(heap.begin(), heap.end(), is_closer);
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end(), is_closer);
+		}
+		const double diff = point[node.axis] - node.point[node.axis];
+		const bool left_first = diff < 0.0;
+		FindNearest(left_first ? begin : mid + 1, left_first ? mid : end, point, count, heap);
+		//по другую сторону плоскости раздела ближе чем на |diff| точек нет
+		if (heap.size() < count || diff * diff <= heap.front().first) {
+			FindNearest(left_first ? mid + 1 : begin, left_first ? end : mid, point, count, heap);
+		}
+	}
+
+	void StopsIndex::FindInRadius(size_t begin, size_t end, const Point& point, double squared_chord, std::vector<size_t>& found) const
+	{
+		if (begin >= end) {
+			return;
+		}
+		const size_t mid = begin + (end - begin) / 2;
+		const Node& node = nodes_[mid];
+		if (SquaredDistance(node.point, point) <= squared_chord) {
+			found.push_back(mid);
+		}
+		const double diff = point[node.axis] - node.point[node.axis];
+		if (diff < 0.0 || diff * diff <= squared_chord) {
+			FindInRadius(begin, mid, point, squared_chord, found);
+		}
+		if (diff >= 0.0 || diff * diff <= squared_chord) {
+			FindInRadius(mid + 1, end, point, squared_chord, found);
+		}
+	}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace catalogue {
+
+	//Пространственный индекс остановок: k-d дерево по точкам единичной сферы.
+	//Расстояние по хорде монотонно по расстоянию по дуге, поэтому поиск по хорде точен
+	//и не спотыкается ни о полюса, ни о линию перемены дат. Строится один раз по справочнику;
+	//остановки, добавленные в справочник позже, в индекс не попадают
+	class StopsIndex {
+	public:
+		using StopsDistances = std::vector<std::pair<const Stop*, double>>; //остановка и расстояние в метрах
+
+		explicit StopsIndex(const TransportCatalogue& catalogue);
+
+		//count ближайших к point остановок по возрастанию расстояния (при равенстве — по названию)
+		StopsDistances Nearest(geo::Coordinates point, size_t count) const;
+
+		//все остановки не дальше radius метров от point, в том же порядке
+		StopsDistances InRadius(geo::Coordinates point, double radius) const;
+
+		size_t GetStopCount() const;
+
+	private:
+		using Point = std::array<double, 3>;
+		using Candidate = std::pair<double, size_t>; //квадрат хорды и номер узла
+
+		struct Node {
+			Point point;
+			const Stop* stop = nullptr;
+			std::uint8_t axis = 0; //ось, по которой делится поддерево с корнем в этом узле
+		};
+
+		static Point ToPoint(geo::Coordinates coordinates);
+		static double ChordToDistance(double squared_chord);
+		static void SortByDistance(StopsDistances& stops);
+
+		//узлы лежат неявным сбалансированным деревом: корень диапазона [begin, end) — в его середине
+		void Build(size_t begin, size_t end);
+		bool IsCloser(const Candidate& lhs, const Candidate& rhs) const;
+		void FindNearest(size_t begin, size_t end, const Point& point, size_t count, std::vector<Candidate>& heap) const;
+		void FindInRadius(size_t begin, size_t end, const Point& point, double squared_chord, std::vector<size_t>& found) const;
+
+		std::vector<Node> nodes_;
+	};
+
+}
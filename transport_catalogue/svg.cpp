@@ -109,6 +109,10 @@ namespace svg {
         return *this;
     }
 
+    size_t Circle::GetMemoryUsage() const {
+        return sizeof(Circle) + GetColorsHeapBytes();
+    }
+
     void Circle::RenderObject(const RenderContext& context) const {
         auto& out = context.out;
         out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
@@ -129,6 +133,10 @@ namespace svg {
         return *this;
     }
 
+    size_t Polyline::GetMemoryUsage() const {
+        return sizeof(Polyline) + memory::GetHeapBytes(points_) + GetColorsHeapBytes();
+    }
+
     void Polyline::RenderObject(const RenderContext& ctx) const {
         auto& out = ctx.out;
         out << "<polyline points=\""sv
@@ -171,6 +179,11 @@ namespace svg {
         return *this;
     }
 
+    size_t Text::GetMemoryUsage() const {
+        return sizeof(Text) + memory::GetHeapBytes(font_family_) + memory::GetHeapBytes(font_weight_)
+            + memory::GetHeapBytes(data_) + GetColorsHeapBytes();
+    }
+
     void Text::RenderObject(const RenderContext& ctx) const {
         auto& out = ctx.out;
         out << "<text"sv;
@@ -232,4 +245,12 @@ namespace svg {
         out << "</svg>";
     }
 
+    memory::MemoryStats Document::GetMemoryStats() const {
+        size_t objects_bytes = 0;
+        for (const auto& obj : objects_) {
+            objects_bytes += obj->GetMemoryUsage();
+        }
+        return { memory::Describe("objects_", objects_), { "*objects_", objects_.size(), objects_bytes } };
+    }
+
 }  // namespace svg
\ No newline at end of file
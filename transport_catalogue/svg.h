@@ -1,5 +1,7 @@
 #pragma once
 
+#include "memory_stats.h"
+
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -59,6 +61,9 @@ namespace svg {
     public:
         void Render(const RenderContext& context) const;
 
+        // Байты объекта вместе с его собственной памятью в куче (строки)
+        virtual size_t GetMemoryUsage() const = 0;
+
         virtual ~Object() = default;
 
     private:
@@ -172,6 +177,16 @@ namespace svg {
     protected:
         ~PathProps() = default;
 
+        size_t GetColorsHeapBytes() const {
+            size_t bytes = 0;
+            for (const std::optional<Color>* color : { &fill_color_, &stroke_color_ }) {
+                if (*color && std::holds_alternative<std::string>(**color)) {
+                    bytes += memory::GetHeapBytes(std::get<std::string>(**color));
+                }
+            }
+            return bytes;
+        }
+
         void RenderAttrs(std::ostream& out) const {
             using namespace std::literals;
 
@@ -215,6 +230,8 @@ namespace svg {
         Circle& SetCenter(Point center);
         Circle& SetRadius(double radius);
 
+        size_t GetMemoryUsage() const override;
+
     private:
         void RenderObject(const RenderContext& context) const override;
 
@@ -234,6 +251,8 @@ namespace svg {
         // Добавляет очередную вершину к ломаной линии
         Polyline& AddPoint(Point point);
 
+        size_t GetMemoryUsage() const override;
+
     private:
         void RenderObject(const RenderContext& ctx) const override;
 
@@ -264,6 +283,8 @@ namespace svg {
         // Задаёт текстовое содержимое объекта (отображается внутри тега text)
         Text& SetData(std::string data);
 
+        size_t GetMemoryUsage() const override;
+
     private:
         void RenderObject(const RenderContext& ctx) const override;
 
@@ -286,6 +307,9 @@ namespace svg {
         // Выводит в ostream svg-представление документа
         void Render(std::ostream& out) const;
 
+        // массив указателей и сами объекты
+        memory::MemoryStats GetMemoryStats() const;
+
     private:
         std::vector<std::unique_ptr<Object>> objects_;
     };
@@ -0,0 +1,114 @@
+#include "timetable_router.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace catalogue {
+	namespace timetable_router {
+
+		TimetableRouter::TimetableRouter(const TransportCatalogue& catalogue, double bus_velocity)
+		{
+			for (const Stop& stop : catalogue.GetStops()) {
+				stops_.push_back(&stop);
+			}
+			std::vector<double> durations;
+			for (const Bus& bus : catalogue.GetBuses()) {
+				if (bus.departures.empty() || bus.stops.size() < 2) {
+					continue;
+				}
+				durations.clear();
+				for (size_t k = 1; k < bus.stops.size(); ++k) {
+					durations.push_back(catalogue.GetDistance(bus.stops[k - 1], bus.stops[k]) / bus_velocity);
+				}
+				for (const double departure : bus.departures) {
+					const TripId trip = static_cast<TripId>(trip_buses_.size());
+					trip_buses_.push_back(bus.name);
+					double time = departure;
+					std::uint32_t position = 0;
+					for (size_t k = 1; k < bus.stops.size(); ++k) {
+						if (bus.stops[k - 1] == bus.stops[k]) { //повтор остановки подряд не считается перегоном
+							continue;
+						}
+						connections_.push_back({ time, time + durations[k - 1], bus.stops[k - 1]->id, bus.stops[k]->id, trip, position++ });
+						time += durations[k - 1];
+					}
+				}
+			}
+			//при равном отправлении первым идёт перегон, раньше прибывающий: перегон нулевой длины должен
+			//быть просмотрен до перегонов, отправляющихся в тот же момент из его остановки прибытия.
+			//Перегоны одного рейса добавлены по порядку, и устойчивая сортировка этот порядок сохраняет
+			std::stable_sort(connections_.begin(), connections_.end(), [](const Connection& lhs, const Connection& rhs) {
+				return std::tie(lhs.departure_time, lhs.arrival_time) < std::tie(rhs.departure_time, rhs.arrival_time);
+			});
+		}
+
+		std::optional<transport_router::BuiltRoute> TimetableRouter::Route(StopId source, StopId target, double departure_time) const
+		{
+			if (source >= stops_.size() || target >= stops_.size()) {
+				return std::nullopt;
+			}
+
+			std::vector<double> arrival(stops_.size(), NEVER);
+			//для каждой остановки — посадка и высадка поездки, которой в неё приехали раньше всего
+			std::vector<std::pair<ConnectionId, ConnectionId>> journey(stops_.size(), { NO_CONNECTION, NO_CONNECTION });
+			std::vector<ConnectionId> trip_boarding(trip_buses_.size(), NO_CONNECTION);
+			arrival[source] = departure_time;
+
+			const auto first = std::lower_bound(connections_.begin(), connections_.end(), departure_time, [](const Connection& connection, double time) {
+				return connection.departure_time < time;
+			});
+			for (ConnectionId id = static_cast<ConnectionId>(first - connections_.begin()); id < connections_.size(); ++id) {
+				const Connection& connection = connections_[id];
+				if (connection.departure_time >= arrival[target]) { //дальше прибыть раньше уже нельзя
+					break;
+				}
+				if (trip_boarding[connection.trip] == NO_CONNECTION) {
+					if (arrival[connection.departure_stop] > connection.departure_time) { //на этот рейс не успеть
+						continue;
+					}
+					trip_boarding[connection.trip] = id;
+				}
+				if (connection.arrival_time < arrival[connection.arrival_stop]) {
+					arrival[connection.arrival_stop] = connection.arrival_time;
+					journey[connection.arrival_stop] = { trip_boarding[connection.trip], id };
+				}
+			}
+			if (arrival[target] == NEVER) {
+				return std::nullopt;
+			}
+
+			std::vector<std::pair<ConnectionId, ConnectionId>> legs;
+			for (StopId stop = target; stop != source; stop = connections_[journey[stop].first].departure_stop) {
+				legs.push_back(journey[stop]);
+			}
+			std::reverse(legs.begin(), legs.end());
+
+			transport_router::BuiltRoute built_route;
+			built_route.total_time = arrival[target] - departure_time;
+			double time = departure_time;
+			for (const auto& [boarding_id, alighting_id] : legs) {
+				const Connection& boarding = connections_[boarding_id];
+				const Connection& alighting = connections_[alighting_id];
+				transport_router::BuiltRoute::RouteWaitInfo wait_info;
+				wait_info.name = stops_[boarding.departure_stop]->name;
+				wait_info.time = boarding.departure_time - time;
+				built_route.wait_items.push_back(std::move(wait_info));
+				transport_router::BuiltRoute::RouteBusInfo bus_info;
+				bus_info.name = static_cast<std::string>(trip_buses_[boarding.trip]);
+				bus_info.time = alighting.arrival_time - boarding.departure_time;
+				bus_info.span_count = static_cast<int>(alighting.position - boarding.position + 1);
+				built_route.bus_items.push_back(std::move(bus_info));
+				time = alighting.arrival_time;
+			}
+			return built_route;
+		}
+
+		size_t TimetableRouter::GetConnectionCount() const
+		{
+			return connections_.size();
+		}
+
+	}
+}
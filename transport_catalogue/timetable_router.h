@@ -0,0 +1,51 @@
+#pragma once
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+	namespace timetable_router {
+
+		//Маршрутизация по расписанию (Connection Scan Algorithm). Каждое время из bus.departures —
+		//отдельный рейс от первой остановки по всем bus.stops; время между соседними остановками —
+		//дорожное расстояние, делённое на скорость автобуса. Перегоны всех рейсов лежат в одном
+		//массиве, отсортированном по времени отправления (при равенстве — прибытия), и запрос
+		//проходит его один раз подряд, без очереди с приоритетами
+		class TimetableRouter {
+		public:
+			explicit TimetableRouter(const TransportCatalogue& catalogue, double bus_velocity); //bus_velocity в метрах в минуту
+
+			//Самое раннее прибытие в to при выезде из from не раньше departure_time (минуты от начала суток).
+			//Ожидания в ответе — реальные ожидания рейсов по расписанию, а не bus_wait_time;
+			//nullopt, если остановки нет или доехать нельзя
+			std::optional<transport_router::BuiltRoute> Route(StopId from, StopId to, double departure_time) const;
+
+			size_t GetConnectionCount() const;
+
+		private:
+			using TripId = std::uint32_t;
+			using ConnectionId = std::uint32_t;
+			static constexpr ConnectionId NO_CONNECTION = std::numeric_limits<ConnectionId>::max();
+			static constexpr double NEVER = std::numeric_limits<double>::infinity();
+
+			//перегон рейса между соседними остановками
+			struct Connection {
+				double departure_time = 0.0;
+				double arrival_time = 0.0;
+				StopId departure_stop = 0;
+				StopId arrival_stop = 0;
+				TripId trip = 0;
+				std::uint32_t position = 0; //номер перегона в рейсе
+			};
+
+			std::vector<const Stop*> stops_; //по StopId
+			std::vector<std::string_view> trip_buses_; //название маршрута каждого рейса
+			std::vector<Connection> connections_;
+		};
+
+	}
+}
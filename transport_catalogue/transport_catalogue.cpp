@@ -1,97 +1,477 @@
 #include "transport_catalogue.h"
 
-#include <list>
-#include <unordered_set>
+#include <algorithm>
+#include <iterator>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 
 namespace catalogue {
 
 	void TransportCatalogue::AddBus(Bus bus_to_move) {
-		//ComputeDistances
-		int L = 0;
-		double geo = 0.0;
+		std::vector<StopId> stop_ids;
+		std::vector<double> distances;
+		buses_info_.push_back(ComputeBusInfo(InsertBus(std::move(bus_to_move)), stop_ids, distances));
+	}
 
-		geo::Coordinates last_coord = { 0.0, 0.0 },
-			curr_coord = { 0.0, 0.0 };
-		bool first = true;
-		const Stop* last_stop = nullptr;
-		for (const Stop* stop : bus_to_move.stops) {
+	void TransportCatalogue::AddStop(Stop stop) {
+		stop.id = static_cast<StopId>(stops_.size());
+		stop.name = names_.Copy(stop.name);
+		stops_trig_.Add(stop.coordinates);
+		stops_.push_back(std::move(stop));
+		stop_ids_by_names_.emplace(stops_.back().name, stops_.back().id);
+		stops_distances_.emplace_back();
+		removed_stops_.push_back(false);
+		is_frozen_ = false;
+	}
 
-			if (first) {
-				first = false;
-				last_coord = stop->coordinates;
-				last_stop = stop;
+	void TransportCatalogue::AddStops(std::vector<Stop> stops) {
+		const size_t stop_count = stops_.size() + stops.size();
+		stop_ids_by_names_.reserve(stop_count);
+		stops_trig_.Reserve(stop_count);
+		stops_distances_.reserve(stop_count);
+		for (Stop& stop : stops) {
+			AddStop(std::move(stop));
+		}
+	}
+
+	void TransportCatalogue::AddDistances(const std::vector<StopsDistance>& distances) {
+		//сначала переводим названия в номера и считаем, сколько записей добавится каждой остановке
+		std::vector<std::pair<StopId, StopId>> stop_pairs;
+		stop_pairs.reserve(distances.size());
+		std::vector<uint32_t> added(stops_.size(), 0);
+		for (const StopsDistance& distance : distances) {
+			const StopId from = GetStopByName(distance.from)->id;
+			const StopId to = GetStopByName(distance.to)->id;
+			stop_pairs.emplace_back(from, to);
+			++added[from];
+			++added[to];
+		}
+		for (StopId stop = 0; stop < added.size(); ++stop) {
+			if (added[stop] != 0) {
+				stops_distances_[stop].reserve(stops_distances_[stop].size() + added[stop]);
 			}
-			else {
-				curr_coord = stop->coordinates;
-				L += GetDistance(last_stop->name, stop->name);
-				geo += ComputeDistance(last_coord, curr_coord);
-				last_coord = curr_coord;
-				last_stop = stop;
+		}
+		//дописываем в конец списков, а упорядочиваем каждый список один раз
+		for (size_t i = 0; i < distances.size(); ++i) {
+			const auto [from, to] = stop_pairs[i];
+			stops_distances_[from].push_back({ to, distances[i].distance, RoadDistance::NO_DISTANCE });
+			stops_distances_[to].push_back({ from, RoadDistance::NO_DISTANCE, distances[i].distance });
+		}
+		for (StopId stop = 0; stop < added.size(); ++stop) {
+			if (added[stop] == 0) {
+				continue;
 			}
+			RoadDistances& road_distances = stops_distances_[stop];
+			//устойчивая сортировка: из повторов одной пары побеждает добавленный позже, как и у AddDistance
+			std::stable_sort(road_distances.begin(), road_distances.end(), [](const RoadDistance& lhs, const RoadDistance& rhs) {
+				return lhs.stop < rhs.stop;
+			});
+			size_t size = 0;
+			for (const RoadDistance& distance : road_distances) {
+				if (size != 0 && road_distances[size - 1].stop == distance.stop) {
+					RoadDistance& merged = road_distances[size - 1];
+					merged.forward = distance.forward != RoadDistance::NO_DISTANCE ? distance.forward : merged.forward;
+					merged.backward = distance.backward != RoadDistance::NO_DISTANCE ? distance.backward : merged.backward;
+				}
+				else {
+					road_distances[size++] = distance;
+				}
+			}
+			road_distances.resize(size);
 		}
-		buses_.push_back(std::move(bus_to_move));
-		const Bus* bus = &buses_.back();
-		buses_by_names_[bus->name] = bus;
+	}
 
-		//BusInfo
-		for (const Stop* stop : bus->stops) {
-			stops_buses_[stop->name].insert(bus->name);
+	void TransportCatalogue::AddBuses(std::vector<Bus> buses, size_t thread_count) {
+		const BusId first = static_cast<BusId>(buses_.size());
+		bus_ids_by_names_.reserve(buses_.size() + buses.size());
+		for (Bus& bus : buses) {
+			InsertBus(std::move(bus));
 		}
+		buses_info_.resize(buses_.size());
 
-		//count unique stops
-		std::unordered_set<const Stop*> unique_stops(bus->stops.begin(), bus->stops.end());
+		//BusInfo маршрутов независимы: каждый поток считает свой непрерывный диапазон
+		const size_t bus_count = buses_.size() - first;
+		if (thread_count == 0) {
+			thread_count = std::thread::hardware_concurrency();
+		}
+		thread_count = std::max<size_t>(1, std::min(thread_count, bus_count / MIN_BUSES_PER_THREAD));
+		const auto compute_range = [this, first, bus_count, thread_count](size_t thread_index) {
+			std::vector<StopId> stop_ids;
+			std::vector<double> distances;
+			const size_t begin = first + bus_count * thread_index / thread_count;
+			const size_t end = first + bus_count * (thread_index + 1) / thread_count;
+			for (size_t id = begin; id < end; ++id) {
+				buses_info_[id] = ComputeBusInfo(buses_[id], stop_ids, distances);
+			}
+		};
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count - 1);
+		for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+			threads.emplace_back(compute_range, thread_index);
+		}
+		compute_range(0);
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
 
-		bus_info_by_name_.emplace(bus->name, BusInfo{ static_cast<int>(bus->stops.size()), static_cast<int>(unique_stops.size()), L, static_cast<double>(L) / geo });
+	const Bus& TransportCatalogue::InsertBus(Bus bus_to_move) {
+		bus_to_move.id = static_cast<BusId>(buses_.size());
+		bus_to_move.name = names_.Copy(bus_to_move.name);
+		bus_to_move.stops = bus_stops_.Copy(bus_to_move.stops.begin(), bus_to_move.stops.end());
+		buses_.push_back(std::move(bus_to_move));
+		const Bus& bus = buses_.back();
+		bus_ids_by_names_[bus.name] = bus.id;
+		removed_buses_.push_back(false);
+		is_frozen_ = false;
+		return bus;
 	}
 
-	void TransportCatalogue::AddStop(Stop stop) {
-		stops_.push_back(std::move(stop));
-		stops_by_names_.emplace(stops_.back().name, &stops_.back());
+	BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus, std::vector<StopId>& stop_ids, std::vector<double>& distances) const {
+		stop_ids.clear();
+		for (const Stop* stop : bus.stops) {
+			stop_ids.push_back(stop->id);
+		}
+
+		//ComputeDistances: географические расстояния всех перегонов одним пакетом
+		const size_t legs = stop_ids.empty() ? 0 : stop_ids.size() - 1;
+		distances.resize(legs);
+		geo::ComputeDistances(stops_trig_, stop_ids.data(), stop_ids.data() + 1, legs, distances.data());
+		int L = 0;
+		double geo = 0.0;
+		for (size_t k = 1; k < stop_ids.size(); ++k) {
+			L += GetDistance(stop_ids[k - 1], stop_ids[k]);
+			geo += distances[k - 1];
+		}
+
+		//count unique stops
+		std::sort(stop_ids.begin(), stop_ids.end());
+		stop_ids.erase(std::unique(stop_ids.begin(), stop_ids.end()), stop_ids.end());
+
+		return BusInfo{ static_cast<int>(bus.stops.size()), static_cast<int>(stop_ids.size()), L, static_cast<double>(L) / geo };
 	}
 
 	const Bus* TransportCatalogue::GetBusByName(std::string_view bus_name) const {
-		return buses_by_names_.at(bus_name);
+		return &buses_[bus_ids_by_names_.at(bus_name)];
 	}
 
 	const Stop* TransportCatalogue::GetStopByName(std::string_view stop_name) const {
-		return stops_by_names_.at(stop_name);
+		return &stops_[stop_ids_by_names_.at(stop_name)];
 	}
 
 	const BusInfo* TransportCatalogue::GetBusInfo(std::string_view bus_name) const
 	{
-		if (bus_info_by_name_.count(bus_name) == 0) {
+		const std::optional<BusId> id = FindBusId(bus_name);
+		if (!id) {
 			return nullptr;
 		}
-		return &bus_info_by_name_.at(bus_name);
+		return &buses_info_[*id];
 	}
 
 	std::optional<StopInfo> TransportCatalogue::GetStopInfo(std::string_view stop_name) const {
-		if (stops_buses_.count(stop_name) == 0) {
-			if (stops_by_names_.count(stop_name) == 0) {
-				return std::nullopt;
+		const std::optional<StopId> id = FindStopId(stop_name);
+		if (!id) {
+			return std::nullopt;
+		}
+		return GetStopInfo(*id);
+	}
+
+	std::optional<StopId> TransportCatalogue::FindStopId(std::string_view stop_name) const {
+		const auto it = stop_ids_by_names_.find(stop_name);
+		if (it == stop_ids_by_names_.end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	std::optional<BusId> TransportCatalogue::FindBusId(std::string_view bus_name) const {
+		const auto it = bus_ids_by_names_.find(bus_name);
+		if (it == bus_ids_by_names_.end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	const Stop& TransportCatalogue::GetStop(StopId id) const {
+		return stops_.at(id);
+	}
+
+	const Bus& TransportCatalogue::GetBus(BusId id) const {
+		return buses_.at(id);
+	}
+
+	const BusInfo& TransportCatalogue::GetBusInfo(BusId id) const {
+		return buses_info_.at(id);
+	}
+
+	StopInfo TransportCatalogue::GetStopInfo(StopId id) const {
+		if (!is_frozen_) {
+			throw std::logic_error("TransportCatalogue::Freeze must be called before GetStopInfo");
+		}
+		const StopBusesRow row = stops_buses_rows_.at(id);
+		return { stops_buses_.data() + row.begin, row.size };
+	}
+
+	void TransportCatalogue::Freeze() {
+		//подсчёт вхождений по остановкам, затем раскладка по строкам (сортировка подсчётом)
+		stops_buses_rows_.assign(stops_.size(), StopBusesRow{});
+		for (const Bus& bus : buses_) {
+			for (const Stop* stop : bus.stops) {
+				++stops_buses_rows_[stop->id].size;
+			}
+		}
+		uint32_t total = 0;
+		for (StopBusesRow& row : stops_buses_rows_) {
+			row.begin = total;
+			total += row.size;
+		}
+		std::vector<BusId> buses(total);
+		std::vector<uint32_t> filled(stops_.size());
+		for (StopId stop = 0; stop < filled.size(); ++stop) {
+			filled[stop] = stops_buses_rows_[stop].begin;
+		}
+		for (const Bus& bus : buses_) {
+			for (const Stop* stop : bus.stops) {
+				buses[filled[stop->id]++] = bus.id;
+			}
+		}
+
+		//в каждой строке — по названию и без повторов (маршрут проходит остановку несколько раз);
+		//строки уплотняются на месте, поэтому начала пересчитываются по ходу
+		const auto by_name = [this](BusId lhs, BusId rhs) {
+			return IsBusNameLess(lhs, rhs);
+		};
+		const auto same_name = [this](BusId lhs, BusId rhs) {
+			return buses_[lhs].name == buses_[rhs].name;
+		};
+		uint32_t size = 0;
+		for (StopBusesRow& row : stops_buses_rows_) {
+			const auto first = buses.begin() + row.begin;
+			const auto last = first + row.size;
+			std::sort(first, last, by_name);
+			const auto unique_last = std::unique(first, last, same_name);
+			row.begin = size;
+			size = static_cast<uint32_t>(std::copy(first, unique_last, buses.begin() + size) - buses.begin());
+			row.size = size - row.begin;
+		}
+		buses.resize(size);
+		buses.shrink_to_fit();
+		stops_buses_ = std::move(buses);
+		is_frozen_ = true;
+	}
+
+	bool TransportCatalogue::IsFrozen() const {
+		return is_frozen_;
+	}
+
+	void TransportCatalogue::RemoveBus(std::string_view bus_name) {
+		const BusId id = GetBusByName(bus_name)->id;
+		Bus& bus = buses_[id];
+		if (is_frozen_) {
+			std::vector<StopId> stop_ids;
+			CollectUniqueStops(bus, stop_ids);
+			for (const StopId stop : stop_ids) {
+				EraseStopBus(stop, id);
 			}
-			else {
-				return nullptr;
+		}
+		bus_ids_by_names_.erase(bus.name);
+		//название стираем только после того, как по нему убрана запись из bus_ids_by_names_
+		bus.name = {};
+		bus.stops = {};
+		bus.departures.clear();
+		buses_info_[id] = BusInfo{};
+		removed_buses_[id] = true;
+	}
+
+	void TransportCatalogue::UpdateBusStops(std::string_view bus_name, arena::Span<const Stop*> stops, bool is_roundtrip) {
+		const BusId id = GetBusByName(bus_name)->id;
+		Bus& bus = buses_[id];
+		std::vector<StopId> old_stops;
+		if (is_frozen_) {
+			CollectUniqueStops(bus, old_stops);
+		}
+		//прежний список остаётся в пуле до разрушения справочника
+		bus.stops = bus_stops_.Copy(stops.begin(), stops.end());
+		bus.is_roundtrip = is_roundtrip;
+		std::vector<StopId> new_stops;
+		std::vector<double> distances;
+		buses_info_[id] = ComputeBusInfo(bus, new_stops, distances);
+		if (!is_frozen_) {
+			return;
+		}
+		//строки индекса меняются только у остановок, которые маршрут покинул или приобрёл
+		std::vector<StopId> changed;
+		std::set_difference(old_stops.begin(), old_stops.end(), new_stops.begin(), new_stops.end(), std::back_inserter(changed));
+		for (const StopId stop : changed) {
+			EraseStopBus(stop, id);
+		}
+		changed.clear();
+		std::set_difference(new_stops.begin(), new_stops.end(), old_stops.begin(), old_stops.end(), std::back_inserter(changed));
+		for (const StopId stop : changed) {
+			InsertStopBus(stop, id);
+		}
+	}
+
+	void TransportCatalogue::RemoveStop(std::string_view stop_name) {
+		const StopId id = GetStopByName(stop_name)->id;
+		std::vector<BusId> buses;
+		CollectStopBuses(id, buses);
+		if (!buses.empty()) {
+			throw std::logic_error("Unable to remove stop " + std::string(stop_name) + ": it is used by bus " + std::string(buses_[buses.front()].name));
+		}
+		//пара расстояний хранится у обеих остановок: убираем и зеркальные записи у соседей
+		for (const RoadDistance& distance : stops_distances_[id]) {
+			if (distance.stop == id) {
+				continue;
 			}
+			RoadDistances& neighbour = stops_distances_[distance.stop];
+			const auto it = std::lower_bound(neighbour.begin(), neighbour.end(), id, [](const RoadDistance& lhs, StopId stop) {
+				return lhs.stop < stop;
+			});
+			if (it != neighbour.end() && it->stop == id) {
+				neighbour.erase(it);
+			}
+		}
+		stops_distances_[id] = RoadDistances{};
+		stop_ids_by_names_.erase(stops_[id].name);
+		stops_[id].name = {};
+		removed_stops_[id] = true;
+	}
+
+	void TransportCatalogue::UpdateDistance(std::string_view from_name, std::string_view to_name, uint32_t distance) {
+		const Stop* from = GetStopByName(from_name);
+		const Stop* to = GetStopByName(to_name);
+		AddDistance(from, to, distance);
+		//изменились перегоны from -> to и, если обратное расстояние не задано, to -> from; оба проходят через from
+		std::vector<BusId> buses;
+		CollectStopBuses(from->id, buses);
+		std::vector<StopId> stop_ids;
+		std::vector<double> distances;
+		for (const BusId bus : buses) {
+			buses_info_[bus] = ComputeBusInfo(buses_[bus], stop_ids, distances);
+		}
+	}
+
+	bool TransportCatalogue::IsStopRemoved(StopId id) const {
+		return removed_stops_.at(id);
+	}
+
+	bool TransportCatalogue::IsBusRemoved(BusId id) const {
+		return removed_buses_.at(id);
+	}
+
+	void TransportCatalogue::CollectUniqueStops(const Bus& bus, std::vector<StopId>& stop_ids) {
+		stop_ids.clear();
+		for (const Stop* stop : bus.stops) {
+			stop_ids.push_back(stop->id);
+		}
+		std::sort(stop_ids.begin(), stop_ids.end());
+		stop_ids.erase(std::unique(stop_ids.begin(), stop_ids.end()), stop_ids.end());
+	}
+
+	void TransportCatalogue::CollectStopBuses(StopId stop, std::vector<BusId>& buses) const {
+		buses.clear();
+		if (is_frozen_) {
+			const StopInfo row = GetStopInfo(stop);
+			buses.assign(row.begin(), row.end());
+			return;
+		}
+		for (const Bus& bus : buses_) {
+			if (std::any_of(bus.stops.begin(), bus.stops.end(), [stop](const Stop* bus_stop) { return bus_stop->id == stop; })) {
+				buses.push_back(bus.id);
+			}
+		}
+	}
+
+	void TransportCatalogue::InsertStopBus(StopId stop, BusId bus) {
+		StopBusesRow& row = stops_buses_rows_[stop];
+		const auto first = stops_buses_.begin() + row.begin;
+		const auto it = std::lower_bound(first, first + row.size, bus, [this](BusId lhs, BusId rhs) {
+			return IsBusNameLess(lhs, rhs);
+		});
+		if (it != first + row.size && buses_[*it].name == buses_[bus].name) { //как и Freeze, одноимённые маршруты не повторяем
+			return;
+		}
+		const uint32_t position = static_cast<uint32_t>(it - first);
+		if (row.begin + row.size == stops_buses_.size()) { //последней строке есть куда расти
+			stops_buses_.insert(it, bus);
+			++row.size;
+			return;
+		}
+		//строке тесно: переносим её в конец, прежнее место освободит Freeze
+		const uint32_t begin = static_cast<uint32_t>(stops_buses_.size());
+		stops_buses_.reserve(stops_buses_.size() + row.size + 1);
+		for (uint32_t i = 0; i < row.size; ++i) {
+			if (i == position) {
+				stops_buses_.push_back(bus);
+			}
+			const BusId moved = stops_buses_[row.begin + i];
+			stops_buses_.push_back(moved);
+		}
+		if (position == row.size) {
+			stops_buses_.push_back(bus);
+		}
+		row = { begin, row.size + 1 };
+	}
+
+	void TransportCatalogue::EraseStopBus(StopId stop, BusId bus) {
+		StopBusesRow& row = stops_buses_rows_[stop];
+		const auto first = stops_buses_.begin() + row.begin;
+		const auto last = first + row.size;
+		const auto it = std::find(first, last, bus);
+		if (it != last) {
+			std::copy(it + 1, last, it);
+			--row.size;
+		}
+	}
+
+	bool TransportCatalogue::IsBusNameLess(BusId lhs, BusId rhs) const {
+		return buses_[lhs].name < buses_[rhs].name;
+	}
+
+	namespace {
+		RoadDistances::iterator FindOrInsert(RoadDistances& distances, StopId stop) {
+			const auto it = std::lower_bound(distances.begin(), distances.end(), stop, [](const RoadDistance& distance, StopId id) {
+				return distance.stop < id;
+			});
+			if (it != distances.end() && it->stop == stop) {
+				return it;
+			}
+			return distances.insert(it, RoadDistance{ stop });
 		}
-		return &stops_buses_.at(stop_name);
 	}
 
 	void TransportCatalogue::AddDistance(std::string_view from_name, std::string_view to_name, uint32_t distance) {
-		stops_distances_[{GetStopByName(from_name), GetStopByName(to_name)}] = distance;
+		AddDistance(GetStopByName(from_name), GetStopByName(to_name), distance);
+	}
+
+	void TransportCatalogue::AddDistance(const Stop* from, const Stop* to, uint32_t distance) {
+		FindOrInsert(stops_distances_[from->id], to->id)->forward = distance;
+		FindOrInsert(stops_distances_[to->id], from->id)->backward = distance;
 	}
 
 	uint32_t TransportCatalogue::GetDistance(std::string_view from_name, std::string_view to_name) const {
-		const Stop* from = GetStopByName(from_name),
-			* to = GetStopByName(to_name);
-		if (stops_distances_.count({ from, to }) != 0) {
-			return stops_distances_.at({ from, to });
-		}
-		if (stops_distances_.count({ to, from }) != 0) {
-			return stops_distances_.at({ to, from });
+		return GetDistance(GetStopByName(from_name), GetStopByName(to_name));
+	}
+
+	uint32_t TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
+		return GetDistance(from->id, to->id);
+	}
+
+	uint32_t TransportCatalogue::GetDistance(StopId from, StopId to) const {
+		const RoadDistances& distances = stops_distances_[from];
+		const auto it = std::lower_bound(distances.begin(), distances.end(), to, [](const RoadDistance& distance, StopId id) {
+			return distance.stop < id;
+		});
+		if (it == distances.end() || it->stop != to) {
+			return {};
 		}
-		return {};
+		return it->forward != RoadDistance::NO_DISTANCE ? it->forward
+			: it->backward != RoadDistance::NO_DISTANCE ? it->backward
+			: 0;
 	}
 
 	const std::deque<Bus>& TransportCatalogue::GetBuses() const {
@@ -106,7 +486,36 @@ namespace catalogue {
 		return stops_.size();
 	}
 
-	const std::unordered_map<std::pair<const Stop*, const Stop*>, uint32_t, PairHasher>& TransportCatalogue::GetStopsDistances() const{
+	memory::MemoryStats TransportCatalogue::GetMemoryStats() const {
+		size_t departures = 0;
+		size_t departures_bytes = 0;
+		size_t bus_stops = 0;
+		for (const Bus& bus : buses_) {
+			departures += bus.departures.size();
+			departures_bytes += memory::GetBytes(bus.departures);
+			bus_stops += bus.stops.size();
+		}
+		const size_t trig_bytes = memory::GetBytes(stops_trig_.sin_lat) + memory::GetBytes(stops_trig_.cos_lat)
+			+ memory::GetBytes(stops_trig_.sin_lng) + memory::GetBytes(stops_trig_.cos_lng);
+		return {
+			memory::Describe("stops_", stops_),
+			memory::Describe("buses_", buses_),
+			{ "buses_.departures", departures, departures_bytes },
+			{ "names_", stops_.size() + buses_.size(), names_.GetAllocatedSize() },
+			{ "bus_stops_", bus_stops, bus_stops_.GetAllocatedSize() },
+			{ "stops_trig_", stops_trig_.Size(), trig_bytes },
+			memory::Describe("stop_ids_by_names_", stop_ids_by_names_),
+			memory::Describe("bus_ids_by_names_", bus_ids_by_names_),
+			memory::Describe("stops_buses_rows_", stops_buses_rows_),
+			memory::Describe("stops_buses_", stops_buses_),
+			memory::Describe("stops_distances_", stops_distances_),
+			memory::Describe("buses_info_", buses_info_),
+			memory::Describe("removed_stops_", removed_stops_),
+			memory::Describe("removed_buses_", removed_buses_),
+		};
+	}
+
+	const std::vector<RoadDistances>& TransportCatalogue::GetStopsDistances() const{
 		return stops_distances_;
 	}
 
@@ -1,52 +1,139 @@
 #pragma once
 #include "domain.h"
+#include "arena.h"
+#include "memory_stats.h"
 
 #include <unordered_map>
-#include <set>
 #include <deque>
 #include <cstdint>
+#include <limits>
 #include <string_view>
 #include <optional>
+#include <vector>
 
 namespace catalogue {
 
-	class PairHasher {
-	public:
-		size_t operator()(std::pair<const Stop*, const Stop*> to_hash) const {
-			return static_cast<size_t>(hasher_(to_hash.first) * 37 + hasher_(to_hash.second));
-		}
-	private:
-		std::hash<const void*> hasher_;
+	//Дорожное расстояние до соседней остановки. Пара хранится у обеих остановок: у from заполнено forward,
+	//у to — backward, поэтому расстояние "в обратную сторону" находится тем же поиском
+	struct RoadDistance {
+		static constexpr uint32_t NO_DISTANCE = std::numeric_limits<uint32_t>::max();
+
+		StopId stop = 0;
+		uint32_t forward = NO_DISTANCE;  //задано от владельца списка до stop
+		uint32_t backward = NO_DISTANCE; //задано от stop до владельца списка
+	};
+
+	using RoadDistances = std::vector<RoadDistance>; //по возрастанию stop
+
+	struct StopsDistance {
+		std::string_view from;
+		std::string_view to;
+		uint32_t distance = 0;
 	};
 
 	class TransportCatalogue {
 	public:
 		void AddBus(Bus bus);
 		void AddStop(Stop stop);
+
+		//Пакетная загрузка с тем же результатом, что и добавление по одному: контейнеры резервируются сразу,
+		//списки расстояний упорядочиваются один раз, BusInfo новых маршрутов считаются в thread_count
+		//потоках (0 — по числу ядер). Остановки всех buses должны быть уже добавлены
+		void AddStops(std::vector<Stop> stops);
+		void AddDistances(const std::vector<StopsDistance>& distances);
+		void AddBuses(std::vector<Bus> buses, size_t thread_count = 0);
+
+		//Собирает индекс "остановка -> маршруты" в сжатые строки (CSR): номера маршрутов всех остановок
+		//лежат в одном массиве, у каждой остановки — свой срез. Вызывается после загрузки;
+		//AddStop/AddBus снимают заморозку, и до следующего Freeze GetStopInfo бросает std::logic_error
+		void Freeze();
+		bool IsFrozen() const;
+
+		//Правка загруженного справочника без перестроения: индекс "остановка -> маршруты", BusInfo
+		//и списки расстояний обновляются на месте. Номера не переиспользуются: удалённые остановки и маршруты
+		//остаются в GetStops/GetBuses пустыми записями с пустым названием, само название снова свободно
+		//(строка остаётся в пуле до разрушения справочника). Маршрутизатор об изменениях не знает:
+		//его перестраивает TransportRouter::Rebuild. Неизвестное название — std::out_of_range
+		void RemoveBus(std::string_view bus_name);
+		//stops — полный список остановок, как Bus::stops при AddBus; расписание маршрута сохраняется
+		void UpdateBusStops(std::string_view bus_name, arena::Span<const Stop*> stops, bool is_roundtrip);
+		//через остановку не должен проходить ни один маршрут, иначе std::logic_error
+		void RemoveStop(std::string_view stop_name);
+		//как AddDistance, но ещё и пересчитывает BusInfo маршрутов, проходящих через from
+		void UpdateDistance(std::string_view from, std::string_view to, uint32_t distance);
+		bool IsStopRemoved(StopId id) const;
+		bool IsBusRemoved(BusId id) const;
 		const Bus* GetBusByName(std::string_view bus_name) const;
 		const Stop* GetStopByName(std::string_view stop_name) const;
 		const BusInfo* GetBusInfo(std::string_view bus_name) const;
 		std::optional<StopInfo> GetStopInfo(std::string_view stop_name) const;
+
+		//Названия переводятся в номера один раз, на границе запроса; дальше всё индексируется номерами
+		std::optional<StopId> FindStopId(std::string_view stop_name) const;
+		std::optional<BusId> FindBusId(std::string_view bus_name) const;
+		const Stop& GetStop(StopId id) const;
+		const Bus& GetBus(BusId id) const;
+		const BusInfo& GetBusInfo(BusId id) const;
+		StopInfo GetStopInfo(StopId id) const; //пустой срез, если через остановку не проходит ни один маршрут
 		void AddDistance(std::string_view from, std::string_view to, uint32_t distance);
+		void AddDistance(const Stop* from, const Stop* to, uint32_t distance);
+		//расстояние from -> to, если не задано — to -> from, если нет и его — 0
 		uint32_t GetDistance(std::string_view from, std::string_view to) const;
-		const std::unordered_map<std::pair<const Stop*, const Stop*>, uint32_t, PairHasher>& GetStopsDistances() const;
+		uint32_t GetDistance(const Stop* from, const Stop* to) const;
+		uint32_t GetDistance(StopId from, StopId to) const;
+		const std::vector<RoadDistances>& GetStopsDistances() const; //по StopId
 
 		const std::deque<Bus>& GetBuses() const;
 		const std::deque<Stop>& GetStops() const;
 
 		size_t GetStopsSize() const;
+
+		//элементы и байты по внутренним контейнерам, для оценки памяти больших баз
+		memory::MemoryStats GetMemoryStats() const;
 	private:
+		//меньше маршрутов на поток не даёт выигрыша от распараллеливания
+		static constexpr size_t MIN_BUSES_PER_THREAD = 64;
+
+		//строка индекса "остановка -> маршруты": stops_buses_[begin, begin + size)
+		struct StopBusesRow {
+			uint32_t begin = 0;
+			uint32_t size = 0;
+		};
+
+		const Bus& InsertBus(Bus bus);
+		//stop_ids и distances — буферы, которые переиспользуются между маршрутами;
+		//на выходе в stop_ids — остановки маршрута без повторов, по возрастанию номера
+		BusInfo ComputeBusInfo(const Bus& bus, std::vector<StopId>& stop_ids, std::vector<double>& distances) const;
+		static void CollectUniqueStops(const Bus& bus, std::vector<StopId>& stop_ids);
+		//маршруты через остановку: из индекса, если он заморожен, иначе перебором
+		void CollectStopBuses(StopId stop, std::vector<BusId>& buses) const;
+		void InsertStopBus(StopId stop, BusId bus);
+		void EraseStopBus(StopId stop, BusId bus);
+		bool IsBusNameLess(BusId lhs, BusId rhs) const;
+
 		std::deque<Stop> stops_;
+		geo::CoordinatesTrig stops_trig_; //по StopId
 		std::deque<Bus> buses_;
 
-		std::unordered_map<std::string_view, const Stop*> stops_by_names_;
-		std::unordered_map<std::string_view, const Bus*> buses_by_names_;
+		//названия остановок и маршрутов и остановки всех маршрутов подряд, по срезу на маршрут
+		arena::StringPool names_;
+		arena::MonotonicPool<const Stop*> bus_stops_;
+
+		std::unordered_map<std::string_view, StopId> stop_ids_by_names_;
+		std::unordered_map<std::string_view, BusId> bus_ids_by_names_;
+
+		//по StopId. После Freeze строки идут подряд без промежутков; строка, которой при правке
+		//стало тесно, переезжает в конец stops_buses_, а освободившееся место занимает до следующего Freeze
+		std::vector<StopBusesRow> stops_buses_rows_;
+		std::vector<BusId> stops_buses_;
+		bool is_frozen_ = false;
 
-		std::unordered_map<std::string_view, std::set<std::string_view>> stops_buses_;
+		std::vector<bool> removed_stops_; //по StopId
+		std::vector<bool> removed_buses_; //по BusId
 
-		std::unordered_map<std::pair<const Stop*, const Stop*>, uint32_t, PairHasher> stops_distances_;
+		std::vector<RoadDistances> stops_distances_; //по StopId
 
-		//BusInfo s
-		std::unordered_map<std::string_view, BusInfo> bus_info_by_name_;
+		//BusInfo s, по BusId
+		std::vector<BusInfo> buses_info_;
 	};
 }
\ No newline at end of file
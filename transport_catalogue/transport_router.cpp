@@ -5,113 +5,551 @@
 #include <utility>
 #include <string>
 #include <list>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <tuple>
 
 namespace catalogue {
 	namespace transport_router {
 
-		TransportRouter::TransportRouter(Graph graph, StopVertexId svi, VertexIdStop vis, EdgesExtraInfo eei, double bus_wait_time)
+		namespace {
+
+			//Рёбра модели STOP_PAIRS: из каждой остановки маршрута до каждой следующей в пределах рейса
+			void AddStopPairsEdges(const TransportCatalogue& catalogue, const RoutingSettings& settings, const TransportRouter::StopVertexId& stop_vertexid,
+				const Bus& bus, std::vector<graph::Edge<double>>& edges, TransportRouter::EdgesExtraInfo& edges_extra_info) {
+				const Stop* last_stop = nullptr;
+				int span_count = 0;
+				double distance = 0.0;
+				graph::VertexId from = 0,
+					to = 0;
+				auto final_station = bus.stops.begin();
+				if (!bus.is_roundtrip) {
+					int steps = bus.stops.size() / 2;
+					std::advance(final_station, steps);
+				}
+				for (auto i = bus.stops.begin(); i != bus.stops.end(); i++) {
+					#define from_stop (*i)
+					span_count = 0;
+					distance = 0.0;
+					last_stop = from_stop;
+					for (auto j = std::next(i, 1); j != bus.stops.end(); j++) {
+						#define to_stop (*j)
+						if (from_stop == to_stop) {
+							last_stop = to_stop;
+							continue;
+						}
+						distance += catalogue.GetDistance(last_stop, to_stop);
+						span_count++;
+						from = stop_vertexid[from_stop->id];
+						to = stop_vertexid[to_stop->id];
+						edges.push_back({ from, to, distance / settings.bus_velocity + settings.bus_wait_time });
+						edges_extra_info.push_back({ bus.name, span_count });
+						last_stop = to_stop;
+						if (j == final_station) {
+							break;
+						}
+					}
+				}
+			}
+
+			//Рёбра модели TRANSIT. Каждый рейс (кольцевой маршрут целиком, некольцевой — отдельно туда и обратно)
+			//получает по вершине на каждую свою остановку и три вида рёбер: посадка (остановка -> рейс, ожидание),
+			//перегон (рейс -> следующая вершина рейса, время в пути) и высадка (рейс -> остановка, 0).
+			//Новые вершины нумеруются начиная с vertex_count; возвращает число вершин графа
+			size_t AddTransitEdges(const TransportCatalogue& catalogue, const RoutingSettings& settings, const TransportRouter::StopVertexId& stop_vertexid,
+				const Bus& bus, size_t vertex_count, std::vector<graph::Edge<double>>& edges, TransportRouter::EdgesExtraInfo& edges_extra_info) {
+				std::vector<const Stop*> trip;
+				const auto add_trip = [&]() {
+					graph::VertexId prev_ride_vertex = 0;
+					for (size_t k = 0; k < trip.size(); ++k) {
+						const graph::VertexId stop_vertex = stop_vertexid[trip[k]->id];
+						const graph::VertexId ride_vertex = vertex_count++;
+						edges.push_back({ stop_vertex, ride_vertex, settings.bus_wait_time });
+						edges_extra_info.push_back({ bus.name, 0 });
+						edges.push_back({ ride_vertex, stop_vertex, 0.0 });
+						edges_extra_info.push_back({ bus.name, 0 });
+						if (k != 0) {
+							edges.push_back({ prev_ride_vertex, ride_vertex, catalogue.GetDistance(trip[k - 1], trip[k]) / settings.bus_velocity });
+							edges_extra_info.push_back({ bus.name, 1 });
+						}
+						prev_ride_vertex = ride_vertex;
+					}
+					trip.clear();
+				};
+				const size_t final_station = bus.is_roundtrip ? bus.stops.size() : bus.stops.size() / 2;
+				for (size_t k = 0; k < bus.stops.size(); ++k) {
+					//повтор остановки подряд не считается перегоном, как и в STOP_PAIRS
+					if (trip.empty() || trip.back() != bus.stops[k]) {
+						trip.push_back(bus.stops[k]);
+					}
+					if (k == final_station) { //через конечную некольцевого маршрута не проехать: обратно идёт другой рейс
+						add_trip();
+						trip.push_back(bus.stops[k]);
+					}
+				}
+				add_trip();
+				return vertex_count;
+			}
+
+			//Рёбра маршрута bus в выбранной модели графа; возвращает новое число вершин графа
+			size_t AddBusEdges(const TransportCatalogue& catalogue, const RoutingSettings& settings, const TransportRouter::StopVertexId& stop_vertexid,
+				const Bus& bus, size_t vertex_count, std::vector<graph::Edge<double>>& edges, TransportRouter::EdgesExtraInfo& edges_extra_info) {
+				switch (settings.graph_model) {
+				case GraphModel::STOP_PAIRS:
+					AddStopPairsEdges(catalogue, settings, stop_vertexid, bus, edges, edges_extra_info);
+					break;
+				case GraphModel::TRANSIT:
+					vertex_count = AddTransitEdges(catalogue, settings, stop_vertexid, bus, vertex_count, edges, edges_extra_info);
+					break;
+				}
+				return vertex_count;
+			}
+
+			//Граф по текущему состоянию catalogue. Вершины остановок нумеруются так же, как остановки в справочнике;
+			//вершина удалённой остановки остаётся, но ни с чем не связана, а удалённые маршруты рёбер не дают
+			TransportRouter::Graph BuildGraph(const TransportCatalogue& catalogue, const RoutingSettings& settings, TransportRouter::StopVertexId& stop_vertexid,
+				TransportRouter::VertexIdStop& vertexid_stop, TransportRouter::EdgesExtraInfo& edges_extra_info) {
+				std::vector<graph::Edge<double>> edges;
+				for (const auto& stop : catalogue.GetStops()) {
+					const bool removed = catalogue.IsStopRemoved(stop.id);
+					stop_vertexid.push_back(removed ? TransportRouter::NO_VERTEX : static_cast<graph::VertexId>(stop.id));
+					vertexid_stop.push_back(removed ? nullptr : &stop);
+				}
+				size_t vertex_count = vertexid_stop.size();
+				for (const Bus& bus : catalogue.GetBuses()) {
+					if (!catalogue.IsBusRemoved(bus.id)) {
+						vertex_count = AddBusEdges(catalogue, settings, stop_vertexid, bus, vertex_count, edges, edges_extra_info);
+					}
+				}
+				vertexid_stop.resize(vertex_count, nullptr);
+				TransportRouter::Graph graph(vertex_count);
+				for (graph::Edge<double>& edge : edges) {
+					graph.AddEdge(std::move(edge));
+				}
+				return graph;
+			}
+
+		}
+
+		TransportRouter::TransportRouter(Graph graph, StopVertexId svi, VertexIdStop vis, EdgesExtraInfo eei, RoutingSettings settings)
 			: graph_(std::move(graph))
-			, router_(graph_)
 			, stop_vertexid_(move(svi))
 			, vertexid_stop_(move(vis))
 			, edges_extra_info_(move(eei))
-			, bus_wait_time_(bus_wait_time) {
+			, settings_(settings)
+			, route_cache_(settings.route_cache_capacity) {
+			graph_.Freeze(); //рёбра больше не добавляются: маршрутизаторы работают с CSR-представлением
+			InitializeRouters();
 		}
 
-		TransportRouter::TransportRouter(Graph graph, graph::Router<double>::RoutesInternalData router_internal_data, StopVertexId svi, VertexIdStop vis, EdgesExtraInfo eei, double bus_wait_time)
+		TransportRouter::TransportRouter(Graph graph, graph::Router<double>::RoutesInternalData router_internal_data, graph::ContractionHierarchy<double>::Data contraction_hierarchy_data, StopVertexId svi, VertexIdStop vis, EdgesExtraInfo eei, RoutingSettings settings)
 			: graph_(std::move(graph))
-			, router_(graph_, std::move(router_internal_data))
 			, stop_vertexid_(std::move(svi))
 			, vertexid_stop_(std::move(vis))
 			, edges_extra_info_(std::move(eei))
-			, bus_wait_time_(bus_wait_time) {
+			, settings_(settings)
+			, route_cache_(settings.route_cache_capacity) {
+			graph_.Freeze();
+			switch (settings_.router_type) {
+			case RouterType::ALL_PAIRS:
+				router_.emplace(graph_, std::move(router_internal_data));
+				break;
+			case RouterType::DIJKSTRA:
+				dijkstra_router_.emplace(graph_);
+				break;
+			case RouterType::A_STAR:
+				dijkstra_router_.emplace(graph_);
+				InitializeAStar();
+				break;
+			case RouterType::CONTRACTION_HIERARCHIES:
+				contraction_hierarchy_.emplace(graph_, std::move(contraction_hierarchy_data));
+				break;
+			}
 		}
 
-		std::optional<BuiltRoute> TransportRouter::Route(std::string_view from, std::string_view to) const
+		std::optional<double> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to, std::vector<graph::EdgeId>& edges) const
 		{
-			if (stop_vertexid_.count(from) == 0 || stop_vertexid_.count(to) == 0) {
+			if (router_) {
+				return router_->BuildRoute(from, to, edges);
+			}
+			std::optional<graph::Router<double>::RouteInfo> route_info;
+			if (contraction_hierarchy_) {
+				route_info = contraction_hierarchy_->BuildRoute(from, to);
+			}
+			else if (settings_.router_type == RouterType::A_STAR) {
+				route_info = dijkstra_router_->BuildRoute(from, to, [this, to](graph::VertexId vertex) {
+					return GetAStarHeuristic(vertex, to);
+				});
+			}
+			else {
+				route_info = dijkstra_router_->BuildRoute(from, to);
+			}
+			if (!route_info) {
+				edges.clear();
 				return std::nullopt;
 			}
-			auto route_info = router_.BuildRoute(stop_vertexid_.at(from), stop_vertexid_.at(to));
-			if (!route_info.has_value()) {
+			edges.assign(route_info->edges.begin(), route_info->edges.end());
+			return route_info->weight;
+		}
+
+		bool TransportRouter::IsStopVertex(graph::VertexId vertex) const
+		{
+			return vertex < vertexid_stop_.size() && vertexid_stop_[vertex] != nullptr;
+		}
+
+		std::optional<graph::VertexId> TransportRouter::GetStopVertex(StopId stop) const
+		{
+			if (stop >= stop_vertexid_.size() || stop_vertexid_[stop] == NO_VERTEX) {
 				return std::nullopt;
 			}
+			return stop_vertexid_[stop];
+		}
 
+		void TransportRouter::InitializeAStar()
+		{
+			//синусы и косинусы считаются один раз на остановку, а не на каждый вызов эвристики
+			a_star_points_ = geo::CoordinatesTrig{};
+			a_star_vertex_points_.assign(graph_.GetVertexCount(), 0);
+			for (graph::VertexId vertex_id = 0; vertex_id < vertexid_stop_.size(); ++vertex_id) {
+				if (vertexid_stop_[vertex_id] != nullptr) {
+					a_star_vertex_points_[vertex_id] = static_cast<std::uint32_t>(a_star_points_.Size());
+					a_star_points_.Add(vertexid_stop_[vertex_id]->coordinates);
+				}
+			}
+			//в модели TRANSIT вершина рейса стоит там же, откуда в неё ведёт ребро посадки
+			for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				if (IsStopVertex(edge.from) && !IsStopVertex(edge.to)) {
+					a_star_vertex_points_[edge.to] = a_star_vertex_points_[edge.from];
+				}
+			}
+			//Дорожные расстояния задаются во входных данных и могут быть короче расстояния по прямой.
+			//Чтобы эвристика не переоценивала время, расстояние по прямой умножается на минимальное
+			//по всем рёбрам отношение "дорожное расстояние / расстояние по прямой"
+			double ratio = std::numeric_limits<double>::infinity();
+			for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				const double geo_distance = geo::ComputeDistance(a_star_points_, a_star_vertex_points_[edge.from], a_star_vertex_points_[edge.to]);
+				if (geo_distance > 0.0) {
+					//ожидание входит только в рёбра между остановками (STOP_PAIRS), у перегонов TRANSIT его нет
+					const double ride_time = IsStopVertex(edge.from) && IsStopVertex(edge.to) ? edge.weight - settings_.bus_wait_time : edge.weight;
+					ratio = std::min(ratio, std::max(0.0, ride_time * settings_.bus_velocity) / geo_distance);
+				}
+			}
+			//запас на погрешность вычислений с плавающей точкой
+			a_star_distance_ratio_ = std::isinf(ratio) ? 0.0 : ratio * (1.0 - 1e-9);
+		}
+
+		double TransportRouter::GetAStarHeuristic(graph::VertexId vertex, graph::VertexId to) const
+		{
+			if (vertex == to) {
+				return 0.0;
+			}
+			//любой путь из другой остановки начинается с посадки, а значит, с ожидания;
+			//из вершины рейса (TRANSIT) можно доехать и без него
+			const double wait_time = IsStopVertex(vertex) ? settings_.bus_wait_time : 0.0;
+			return wait_time
+				+ a_star_distance_ratio_ * geo::ComputeDistance(a_star_points_, a_star_vertex_points_[vertex], a_star_vertex_points_[to]) / settings_.bus_velocity;
+		}
+
+		std::optional<BuiltRoute> TransportRouter::Route(StopId from, StopId to) const
+		{
+			RouteView route_view;
+			if (!Route(from, to, route_view)) {
+				return std::nullopt;
+			}
 			BuiltRoute built_route;
-			built_route.total_time = route_info->weight;
+			built_route.total_time = route_view.total_time;
 			BuiltRoute::RouteWaitInfo route_wait_info;
 			BuiltRoute::RouteBusInfo route_bus_info;
-			for (graph::EdgeId edge_id : route_info.value().edges) {
+			for (const RouteView::Item& item : route_view.items) {
 				//WAIT
-				route_wait_info.name = static_cast<std::string>(vertexid_stop_.at(graph_.GetEdge(edge_id).from));
-				route_wait_info.time = bus_wait_time_;
+				route_wait_info.name = static_cast<std::string>(item.stop_name);
+				route_wait_info.time = item.wait_time;
 				built_route.wait_items.push_back(route_wait_info);
 				//BUS
-				route_bus_info.name = static_cast<std::string>(edges_extra_info_.at(edge_id).bus_name);
-				route_bus_info.time = graph_.GetEdge(edge_id).weight - bus_wait_time_;
-				route_bus_info.span_count = edges_extra_info_.at(edge_id).span_count;
+				route_bus_info.name = static_cast<std::string>(item.bus_name);
+				route_bus_info.time = item.bus_time;
+				route_bus_info.span_count = item.span_count;
 				built_route.bus_items.push_back(route_bus_info);
 			}
-
 			return built_route;
 		}
 
-		TransportRouter::TransportRouterData TransportRouter::GetTransportRouterData() const
+		bool TransportRouter::Route(StopId from, StopId to, RouteView& route_view) const
 		{
-			return { graph_, router_, stop_vertexid_, edges_extra_info_, bus_wait_time_ };
+			const std::optional<graph::VertexId> from_vertex = GetStopVertex(from);
+			const std::optional<graph::VertexId> to_vertex = GetStopVertex(to);
+			if (!from_vertex || !to_vertex) {
+				return false;
+			}
+			const std::pair<graph::VertexId, graph::VertexId> key{ *from_vertex, *to_vertex };
+			if (route_cache_.GetCapacity() == 0) {
+				return MakeRouteView(key.first, key.second, route_view);
+			}
+			if (const auto cached = route_cache_.Get(key)) {
+				if (!cached->has_value()) {
+					return false;
+				}
+				route_view.total_time = (*cached)->total_time;
+				route_view.items.assign((*cached)->items.begin(), (*cached)->items.end());
+				return true;
+			}
+			const bool found = MakeRouteView(key.first, key.second, route_view);
+			//рабочий буфер рёбер в кэш не кладём
+			route_cache_.Put(key, found ? std::optional<RouteView>(RouteView{ route_view.total_time, route_view.items, {} }) : std::nullopt);
+			return found;
 		}
 
-		TransportRouter MakeTransportRouter(const TransportCatalogue& catalogue, double bus_wait_time, double bus_velocity) {
-			TransportRouter::StopVertexId stop_vertexid;
-			TransportRouter::VertexIdStop vertexid_stop;
-			TransportRouter::EdgesExtraInfo edges_extra_info;
-			std::vector<graph::Edge<double>> edges;
+		TransportRouter::RouteCacheStats TransportRouter::GetRouteCacheStats() const
+		{
+			return route_cache_.GetStats();
+		}
 
-			const Stop* last_stop = nullptr;
-			int span_count = 0;
-			double distance = 0.0;
-			graph::VertexId current_vertex_id = 0,
-				from = 0,
-				to = 0;
-			for (const auto& stop : catalogue.GetStops()) {
-				stop_vertexid[stop.name] = current_vertex_id;
-				vertexid_stop[current_vertex_id++] = stop.name;
-			}
-			for (const Bus& bus : catalogue.GetBuses()) {
-				auto final_station = bus.stops.begin();
-				if (!bus.is_roundtrip) {
-					int steps = bus.stops.size() / 2;
-					std::advance(final_station, steps);
+		memory::MemoryStats TransportRouter::GetMemoryStats() const
+		{
+			memory::MemoryStats stats;
+			memory::Append(stats, "graph_.", graph_.GetMemoryStats());
+			if (router_) {
+				memory::Append(stats, "router_.", router_->GetMemoryStats());
+			}
+			if (contraction_hierarchy_) {
+				memory::Append(stats, "contraction_hierarchy_.", contraction_hierarchy_->GetMemoryStats());
+			}
+			stats.push_back(memory::Describe("stop_vertexid_", stop_vertexid_));
+			stats.push_back(memory::Describe("vertexid_stop_", vertexid_stop_));
+			stats.push_back(memory::Describe("edges_extra_info_", edges_extra_info_));
+			const size_t a_star_points_bytes = memory::GetBytes(a_star_points_.sin_lat) + memory::GetBytes(a_star_points_.cos_lat)
+				+ memory::GetBytes(a_star_points_.sin_lng) + memory::GetBytes(a_star_points_.cos_lng);
+			stats.push_back({ "a_star_points_", a_star_points_.Size(), a_star_points_bytes });
+			stats.push_back(memory::Describe("a_star_vertex_points_", a_star_vertex_points_));
+			const size_t cache_bytes = route_cache_.GetBytes([](const std::optional<RouteView>& route_view) {
+				return route_view ? memory::GetBytes(route_view->items) + memory::GetBytes(route_view->edges) : 0;
+			});
+			stats.push_back({ "route_cache_", route_cache_.GetStats().size, cache_bytes });
+			return stats;
+		}
+
+		bool TransportRouter::MakeRouteView(graph::VertexId from, graph::VertexId to, RouteView& route_view) const
+		{
+			route_view.items.clear();
+			const std::optional<double> weight = BuildRoute(from, to, route_view.edges);
+			if (!weight) {
+				return false;
+			}
+
+			route_view.total_time = *weight;
+			for (graph::EdgeId edge_id : route_view.edges) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				const EdgeExtraInfo& edge_extra_info = edges_extra_info_[edge_id];
+				const Stop* stop = vertexid_stop_[edge.from];
+				if (stop == nullptr) {
+					//перегон или высадка в модели TRANSIT: продолжаем текущую поездку
+					route_view.items.back().bus_time += edge.weight;
+					route_view.items.back().span_count += edge_extra_info.span_count;
+					continue;
 				}
-				for (auto i = bus.stops.begin(); i != bus.stops.end(); i++) {
-					#define from_stop (*i)
-					span_count = 0;
-					distance = 0.0;
-					last_stop = from_stop;
-					for (auto j = std::next(i, 1); j != bus.stops.end(); j++) {
-						#define to_stop (*j)
-						if (from_stop == to_stop) {
-							last_stop = to_stop;
-							continue;
-						}
-						distance += catalogue.GetDistance(last_stop->name, to_stop->name);
-						span_count++;
-						from = stop_vertexid.at(from_stop->name);
-						to = stop_vertexid.at(to_stop->name);
-						edges.push_back({ from, to, distance / bus_velocity + bus_wait_time });
-						edges_extra_info.push_back({ bus.name, span_count });
-						last_stop = to_stop;
-						if (j == final_station) {
-							break;
-						}
+				route_view.items.push_back({ stop->name, settings_.bus_wait_time,
+					edge_extra_info.bus_name, edge_extra_info.span_count, edge.weight - settings_.bus_wait_time });
+			}
+			return true;
+		}
+
+		std::optional<TransportRouter::TravelTimes> TransportRouter::Matrix(const std::vector<StopId>& sources, const std::vector<StopId>& targets) const
+		{
+			std::vector<graph::VertexId> source_vertices, target_vertices;
+			source_vertices.reserve(sources.size());
+			target_vertices.reserve(targets.size());
+			for (StopId stop : sources) {
+				const std::optional<graph::VertexId> vertex = GetStopVertex(stop);
+				if (!vertex) {
+					return std::nullopt;
+				}
+				source_vertices.push_back(*vertex);
+			}
+			for (StopId stop : targets) {
+				const std::optional<graph::VertexId> vertex = GetStopVertex(stop);
+				if (!vertex) {
+					return std::nullopt;
+				}
+				target_vertices.push_back(*vertex);
+			}
+
+			TravelTimes travel_times;
+			travel_times.reserve(source_vertices.size());
+			if (router_) {
+				//таблица всех пар уже посчитана: просто читаем из неё
+				const auto& routes_internal_data = router_->GetRouterInternalData();
+				for (graph::VertexId from : source_vertices) {
+					auto& row = travel_times.emplace_back();
+					row.reserve(target_vertices.size());
+					for (graph::VertexId to : target_vertices) {
+						const auto route = routes_internal_data.Get(from, to);
+						row.push_back(route ? std::optional<double>(route->weight) : std::nullopt);
+					}
+				}
+				return travel_times;
+			}
+
+			//иначе один поиск из каждого источника сразу до всех целей
+			std::optional<graph::DijkstraRouter<double>> own_router;
+			const graph::DijkstraRouter<double>& router = dijkstra_router_ ? *dijkstra_router_ : own_router.emplace(graph_);
+			for (graph::VertexId from : source_vertices) {
+				travel_times.push_back(router.BuildWeights(from, target_vertices));
+			}
+			return travel_times;
+		}
+
+		void TransportRouter::AddStops(const std::vector<const Stop*>& stops)
+		{
+			graph_.Thaw();
+			for (const Stop* stop : stops) {
+				if (GetStopVertex(stop->id)) {
+					continue;
+				}
+				const graph::VertexId vertex_id = graph_.AddVertex();
+				if (stop->id >= stop_vertexid_.size()) {
+					stop_vertexid_.resize(stop->id + 1, NO_VERTEX);
+				}
+				stop_vertexid_[stop->id] = vertex_id;
+				vertexid_stop_.resize(graph_.GetVertexCount(), nullptr);
+				vertexid_stop_[vertex_id] = stop;
+			}
+			graph_.Freeze();
+			UpdateRouters();
+		}
+
+		void TransportRouter::AddBuses(const TransportCatalogue& catalogue, const std::vector<const Bus*>& buses)
+		{
+			std::vector<graph::Edge<double>> edges;
+			EdgesExtraInfo edges_extra_info;
+			size_t vertex_count = graph_.GetVertexCount();
+			for (const Bus* bus : buses) {
+				vertex_count = AddBusEdges(catalogue, settings_, stop_vertexid_, *bus, vertex_count, edges, edges_extra_info);
+			}
+			edges_extra_info_.insert(edges_extra_info_.end(), edges_extra_info.begin(), edges_extra_info.end());
+			graph_.Thaw();
+			while (graph_.GetVertexCount() < vertex_count) {
+				graph_.AddVertex();
+			}
+			vertexid_stop_.resize(vertex_count, nullptr);
+			for (const graph::Edge<double>& edge : edges) {
+				graph_.AddEdge(edge);
+			}
+			graph_.Freeze();
+			UpdateRouters();
+		}
+
+		void TransportRouter::Rebuild(const TransportCatalogue& catalogue)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			//маршрутизаторы ссылаются на граф: убираем их до замены графа
+			router_.reset();
+			dijkstra_router_.reset();
+			contraction_hierarchy_.reset();
+			stop_vertexid_.clear();
+			vertexid_stop_.clear();
+			edges_extra_info_.clear();
+			graph_ = BuildGraph(catalogue, settings_, stop_vertexid_, vertexid_stop_, edges_extra_info_);
+			graph_.Freeze();
+			InitializeRouters();
+			route_cache_.Clear();
+			last_update_time_ = std::chrono::steady_clock::now() - start;
+		}
+
+		TransportRouter::BuildTime TransportRouter::GetLastUpdateTime() const
+		{
+			return last_update_time_;
+		}
+
+		void TransportRouter::InitializeRouters()
+		{
+			switch (settings_.router_type) {
+			case RouterType::ALL_PAIRS:
+				router_.emplace(graph_, settings_.router_threads);
+				break;
+			case RouterType::DIJKSTRA:
+				dijkstra_router_.emplace(graph_);
+				break;
+			case RouterType::A_STAR:
+				dijkstra_router_.emplace(graph_);
+				InitializeAStar();
+				break;
+			case RouterType::CONTRACTION_HIERARCHIES:
+				contraction_hierarchy_.emplace(graph_);
+				break;
+			}
+		}
+
+		void TransportRouter::UpdateRouters()
+		{
+			const auto start = std::chrono::steady_clock::now();
+			switch (settings_.router_type) {
+			case RouterType::ALL_PAIRS:
+				router_->Update(); //досчитываем только пути через концы новых рёбер
+				break;
+			case RouterType::DIJKSTRA:
+				break;
+			case RouterType::A_STAR:
+				InitializeAStar();
+				break;
+			case RouterType::CONTRACTION_HIERARCHIES:
+				//порядок сокращения зависит от всего графа, поэтому иерархия строится заново
+				contraction_hierarchy_.emplace(graph_);
+				break;
+			}
+			route_cache_.Clear();
+			last_update_time_ = std::chrono::steady_clock::now() - start;
+		}
+
+		std::optional<TransportRouter::ReachableStops> TransportRouter::Reachable(StopId from, double max_time) const
+		{
+			const std::optional<graph::VertexId> from_vertex = GetStopVertex(from);
+			if (!from_vertex) {
+				return std::nullopt;
+			}
+			ReachableStops reachable_stops;
+			if (max_time < 0.0) {
+				return reachable_stops;
+			}
+			if (router_) {
+				//строка таблицы всех пар уже содержит времена до всех вершин
+				const double* weights = router_->GetRouterInternalData().GetWeights(*from_vertex);
+				for (graph::VertexId vertex_id = 0; vertex_id < vertexid_stop_.size(); ++vertex_id) {
+					if (vertexid_stop_[vertex_id] != nullptr && weights[vertex_id] <= max_time) {
+						reachable_stops.emplace_back(vertexid_stop_[vertex_id]->name, weights[vertex_id]);
 					}
 				}
 			}
-			TransportRouter::Graph graph(current_vertex_id);
-			for (graph::Edge<double>& edge : edges) {
-				graph.AddEdge(std::move(edge));
+			else {
+				//иначе поиск, ограниченный бюджетом времени
+				std::optional<graph::DijkstraRouter<double>> own_router;
+				const graph::DijkstraRouter<double>& router = dijkstra_router_ ? *dijkstra_router_ : own_router.emplace(graph_);
+				for (const auto& [vertex_id, time] : router.BuildWeightsWithin(*from_vertex, max_time)) {
+					if (IsStopVertex(vertex_id)) {
+						reachable_stops.emplace_back(vertexid_stop_[vertex_id]->name, time);
+					}
+				}
 			}
-			return TransportRouter{ graph, stop_vertexid, vertexid_stop, edges_extra_info, bus_wait_time };
+			std::sort(reachable_stops.begin(), reachable_stops.end(), [](const auto& lhs, const auto& rhs) {
+				return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+			});
+			return reachable_stops;
+		}
+
+		TransportRouter::TransportRouterData TransportRouter::GetTransportRouterData() const
+		{
+			return { graph_, router_ ? &*router_ : nullptr, contraction_hierarchy_ ? &*contraction_hierarchy_ : nullptr, stop_vertexid_, edges_extra_info_, settings_ };
+		}
+
+		TransportRouter MakeTransportRouter(const TransportCatalogue& catalogue, RoutingSettings settings) {
+			TransportRouter::StopVertexId stop_vertexid;
+			TransportRouter::VertexIdStop vertexid_stop;
+			TransportRouter::EdgesExtraInfo edges_extra_info;
+			TransportRouter::Graph graph = BuildGraph(catalogue, settings, stop_vertexid, vertexid_stop, edges_extra_info);
+			return TransportRouter{ std::move(graph), std::move(stop_vertexid), std::move(vertexid_stop), std::move(edges_extra_info), settings };
 		}
 
 	}
@@ -1,12 +1,18 @@
 ﻿#pragma once
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "lru_cache.h"
+#include "memory_stats.h"
 #include "transport_catalogue.h"
 
+#include <chrono>
 #include <string_view>
-#include <map>
+#include <limits>
 #include <vector>
 #include <optional>
+#include <utility>
 
 namespace catalogue {
 	namespace transport_router {
@@ -24,43 +30,151 @@ namespace catalogue {
 			std::vector<RouteBusInfo> bus_items;
 		};
 
+		//Маршрут без копирования названий: string_view указывают на названия в справочнике.
+		//Один объект можно передавать в TransportRouter::Route раз за разом — память под элементы
+		//и рабочий буфер рёбер выделяется только при первом, самом длинном маршруте
+		struct RouteView {
+			struct Item { //ожидание на остановке и следующая за ним поездка
+				std::string_view stop_name;
+				double wait_time = 0.0;
+				std::string_view bus_name;
+				int span_count = 0;
+				double bus_time = 0.0;
+			};
+			double total_time = 0.0;
+			std::vector<Item> items;
+			std::vector<graph::EdgeId> edges; //рабочий буфер для восстановления пути
+		};
+
+		enum class RouterType {
+			ALL_PAIRS, //Router: предподсчёт всех пар вершин, O(V^3) на построение и O(V^2) памяти
+			DIJKSTRA,  //DijkstraRouter: поиск пути на каждый запрос, O(V + E) памяти
+			CONTRACTION_HIERARCHIES, //ContractionHierarchy: предподсчёт сокращений, быстрый двунаправленный поиск
+			A_STAR,    //DijkstraRouter с эвристикой по координатам остановок, без предподсчёта
+		};
+
+		enum class GraphModel {
+			STOP_PAIRS, //вершина на остановку, ребро на каждую пару остановок маршрута: O(длина маршрута^2) рёбер
+			TRANSIT,    //дополнительно вершина на каждую остановку рейса: посадка, перегоны и высадка, O(длина маршрута) рёбер
+		};
+
+		struct RoutingSettings {
+			double bus_wait_time = 0.0; //минуты
+			double bus_velocity = 0.0;  //метры в минуту
+			RouterType router_type = RouterType::ALL_PAIRS;
+			size_t router_threads = 0; //потоки для построения таблицы ALL_PAIRS, 0 — по числу ядер
+			size_t route_cache_capacity = 0; //сколько последних построенных маршрутов помнить, 0 — не кэшировать
+			GraphModel graph_model = GraphModel::STOP_PAIRS;
+		};
+
 		struct EdgeExtraInfo {
 			std::string_view bus_name;
-			int span_count = 0;
+			int span_count = 0; //в модели TRANSIT: 1 у перегона, 0 у посадки и высадки
+		};
+
+		class VertexPairHasher {
+		public:
+			size_t operator()(std::pair<graph::VertexId, graph::VertexId> to_hash) const {
+				return hasher_(to_hash.first) * 37 + hasher_(to_hash.second);
+			}
+		private:
+			std::hash<graph::VertexId> hasher_;
 		};
 
 		class TransportRouter {
 		public:
-			using StopVertexId = std::map<std::string_view, graph::VertexId>;
-			using VertexIdStop = std::map<graph::VertexId, std::string_view>;
+			using StopVertexId = std::vector<graph::VertexId>; //по StopId; NO_VERTEX — остановки нет в графе
+			using VertexIdStop = std::vector<const Stop*>; //по VertexId; nullptr у вершин рейсов (TRANSIT)
 			using EdgesExtraInfo = std::vector<EdgeExtraInfo>;
 			using Graph = graph::DirectedWeightedGraph<double>;
+			using RouteCacheStats = cache::LruCache<std::pair<graph::VertexId, graph::VertexId>, std::optional<RouteView>, VertexPairHasher>::Stats;
+			using BuildTime = std::chrono::steady_clock::duration;
+			using TravelTimes = std::vector<std::vector<std::optional<double>>>; //[источник][цель], nullopt — маршрута нет
+			using ReachableStops = std::vector<std::pair<std::string_view, double>>; //остановка и время в пути до неё
+
+			static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
 
 			struct TransportRouterData {
 				const Graph& graph;
-				const graph::Router<double>& router;
+				const graph::Router<double>* router; //nullptr, если таблица всех пар не строилась
+				const graph::ContractionHierarchy<double>* contraction_hierarchy; //nullptr, если иерархия не строилась
 				const StopVertexId& stop_vertex_id;
 				const EdgesExtraInfo& edges_extra_info;
-				const double bus_wait_time = 0.0;
+				const RoutingSettings& settings;
 			};
 
-			explicit TransportRouter(Graph, StopVertexId, VertexIdStop, EdgesExtraInfo, double bus_wait_time);//строим граф, а по нему рутер
-			explicit TransportRouter(Graph, graph::Router<double>::RoutesInternalData router_internal_data, StopVertexId, VertexIdStop, EdgesExtraInfo, double bus_wait_time);
+			explicit TransportRouter(Graph, StopVertexId, VertexIdStop, EdgesExtraInfo, RoutingSettings);//строим граф, а по нему рутер
+			explicit TransportRouter(Graph, graph::Router<double>::RoutesInternalData router_internal_data, graph::ContractionHierarchy<double>::Data contraction_hierarchy_data, StopVertexId, VertexIdStop, EdgesExtraInfo, RoutingSettings);
+
+			//Остановки задаются номерами из справочника (Stop::id): названия переводит в номера вызывающий
+
+			std::optional<BuiltRoute> Route(StopId from, StopId to) const;
 
-			std::optional<BuiltRoute> Route(std::string_view from, std::string_view to) const;
+			//маршрут в route_view без выделения памяти под названия; false, если остановки нет в графе или маршрута нет
+			bool Route(StopId from, StopId to, RouteView& route_view) const;
+
+			//матрица времён в пути для всех пар (источник, цель); nullopt, если какой-то остановки нет в графе
+			std::optional<TravelTimes> Matrix(const std::vector<StopId>& sources, const std::vector<StopId>& targets) const;
+
+			//все остановки, до которых из from можно доехать не дольше чем за max_time минут, включая саму from,
+			//по возрастанию времени; nullopt, если остановки нет в графе
+			std::optional<ReachableStops> Reachable(StopId from, double max_time) const;
 
 			TransportRouterData GetTransportRouterData() const;
+
+			//попадания и промахи кэша маршрутов (routing_settings.route_cache_capacity)
+			RouteCacheStats GetRouteCacheStats() const;
+
+			//память графа, построенного маршрутизатора, таблиц соответствия и кэша маршрутов
+			memory::MemoryStats GetMemoryStats() const;
+
+			//Добавляют в граф остановки и маршруты, уже добавленные в catalogue, без полного перестроения:
+			//таблица ALL_PAIRS досчитывается только через концы новых рёбер, A_STAR пересчитывает эвристику,
+			//CONTRACTION_HIERARCHIES строится заново. Кэш маршрутов сбрасывается.
+			//Уже известные остановки пропускаются; расстояния существующих рёбер не меняются
+			void AddStops(const std::vector<const Stop*>& stops);
+			void AddBuses(const TransportCatalogue& catalogue, const std::vector<const Bus*>& buses);
+			//Строит граф и маршрутизатор заново по catalogue — после удалений и правок (RemoveBus, UpdateBusStops и т.п.),
+			//которые AddStops/AddBuses учесть не могут. Кэш маршрутов сбрасывается
+			void Rebuild(const TransportCatalogue& catalogue);
+
+			//время последнего AddStops/AddBuses/Rebuild
+			BuildTime GetLastUpdateTime() const;
 		private:
+			bool MakeRouteView(graph::VertexId from, graph::VertexId to, RouteView& route_view) const;
+			std::optional<double> BuildRoute(graph::VertexId from, graph::VertexId to, std::vector<graph::EdgeId>& edges) const;
+			void InitializeRouters();
+			void UpdateRouters();
+			bool IsStopVertex(graph::VertexId vertex) const;
+			std::optional<graph::VertexId> GetStopVertex(StopId stop) const;
+			void InitializeAStar();
+			double GetAStarHeuristic(graph::VertexId vertex, graph::VertexId to) const;
+
 			Graph graph_;
-			graph::Router<double> router_;
+			//строится ровно один из маршрутизаторов, в зависимости от settings_.router_type
+			std::optional<graph::Router<double>> router_;
+			std::optional<graph::DijkstraRouter<double>> dijkstra_router_;
+			std::optional<graph::ContractionHierarchy<double>> contraction_hierarchy_;
 
 			StopVertexId stop_vertexid_;
 			VertexIdStop vertexid_stop_;
 			EdgesExtraInfo edges_extra_info_;
-			double bus_wait_time_ = 0.0;
+			RoutingSettings settings_;
+
+			//для A_STAR: координаты вершин и нижняя оценка отношения дорожного расстояния к расстоянию по прямой.
+			//У вершины — номер точки в a_star_points_: своя точка у каждой вершины остановки,
+			//вершина рейса (TRANSIT) делит точку со своей остановкой
+			geo::CoordinatesTrig a_star_points_;
+			std::vector<std::uint32_t> a_star_vertex_points_;
+			double a_star_distance_ratio_ = 0.0;
+
+			BuildTime last_update_time_{};
+
+			//кэш готовых ответов по паре (from, to), включая "маршрута нет"
+			mutable cache::LruCache<std::pair<graph::VertexId, graph::VertexId>, std::optional<RouteView>, VertexPairHasher> route_cache_;
 		};
 
-		TransportRouter MakeTransportRouter(const TransportCatalogue& catalogue, double bus_wait_time, double bus_velocity);
+		TransportRouter MakeTransportRouter(const TransportCatalogue& catalogue, RoutingSettings settings);
 
 	}
 }
\ No newline at end of file